@@ -0,0 +1,348 @@
+#include "../include/jsonVariant.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <string>
+#include <vector>
+
+// throughput of parsing, serializing, validating, copying and destroying generated documents, the corpora are made
+// by a fixed pseudo random sequence so every run and every platform measures the same input, results are printed
+// as json to be kept and compared between versions
+//
+// usage: jsonVariantBench [minimal seconds per measurement] [corpus name]
+
+namespace
+{
+    // splitmix64, unlike the standard distributions it gives the same numbers with every standard library
+    class Random
+    {
+    public:
+        explicit Random(uint64_t seed) : state_(seed) {}
+
+        uint64_t next()
+        {
+            uint64_t z = (state_ += 0x9e3779b97f4a7c15ULL);
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+            return z ^ (z >> 31);
+        }
+
+        uint64_t below(uint64_t limit) { return next() % limit; }
+        double unit() { return (next() >> 11) * (1.0 / 9007199254740992.0); }
+
+    private:
+        uint64_t state_;
+    };
+
+    struct Corpus
+    {
+        std::string name;
+        std::vector<std::string> documents;     // more documents are parsed one by one like lines of ndjson
+        std::string schema;
+        size_t bytes = 0;
+    };
+
+    std::string number(double value)
+    {
+        char buffer[32];
+        snprintf(buffer, sizeof(buffer), "%.15g", value);
+        return buffer;
+    }
+
+    std::string words(Random& random, size_t count)
+    {
+        // ascii mixed with two and three byte utf-8 sequences and the escapes the parser keeps verbatim
+        static const char* vocabulary[] = { "json", "variant", "parse", "ko\xc5\xa1\x65\xc4\x8d\x65", "\xc3\xbc\x62\x65r",
+            "\xe6\x97\xa5\xe6\x9c\xac\xe8\xaa\x9e", "\xe3\x83\x86\xe3\x82\xb9\xe3\x83\x88", "line\\nbreak", "\\\"quoted\\\"", "#tag", "@user", "https://t.co/x1" };
+        std::string text;
+        for (size_t i = 0; i < count; i++)
+        {
+            if (i > 0)
+                text += ' ';
+
+            text += vocabulary[random.below(sizeof(vocabulary) / sizeof(vocabulary[0]))];
+        }
+
+        return text;
+    }
+
+    // polygons with long coordinate lists like canada.json
+    Corpus numbersCorpus()
+    {
+        Random random(1);
+        std::string json = R"({"type":"FeatureCollection","features":[)";
+        for (int feature = 0; feature < 8; feature++)
+        {
+            json += std::string(feature ? "," : "") + R"({"type":"Feature","properties":{"name":"Region )" + std::to_string(feature) + R"("},"geometry":{"type":"Polygon","coordinates":[)";
+            for (int ring = 0; ring < 6; ring++)
+            {
+                json += ring ? ",[" : "[";
+                for (int point = 0; point < 2000; point++)
+                    json += std::string(point ? "," : "") + "[" + number(-141.0 + random.unit() * 88.0) + "," + number(41.6 + random.unit() * 41.5) + "]";
+
+                json += "]";
+            }
+
+            json += "]}}";
+        }
+
+        json += "]}";
+        return { "numbers", { json }, R"({"type":"object","required":["type","features"],"properties":{"features":{"type":"array","items":{"type":"object","required":["geometry"]}}}})" };
+    }
+
+    // statuses with users and entities like twitter.json
+    Corpus stringsCorpus()
+    {
+        Random random(2);
+        std::string json = R"({"statuses":[)";
+        for (int status = 0; status < 2000; status++)
+        {
+            json += std::string(status ? "," : "") + R"({"id":)" + std::to_string(1000000000000000000ULL + random.below(1000000000000ULL))
+                + R"(,"text":")" + words(random, 8 + random.below(16)) + R"(","lang":")" + (random.below(2) ? "en" : "ja")
+                + R"(","truncated":false,"in_reply_to":null,"user":{"id":)" + std::to_string(random.below(1000000000))
+                + R"(,"name":")" + words(random, 2) + R"(","screen_name":"user_)" + std::to_string(status)
+                + R"(","description":")" + words(random, 12) + R"(","followers_count":)" + std::to_string(random.below(100000))
+                + R"(,"verified":)" + (random.below(10) ? "false" : "true") + R"(},"entities":{"hashtags":[)";
+            for (uint64_t tag = 0, tags = random.below(4); tag < tags; tag++)
+                json += std::string(tag ? "," : "") + R"({"text":")" + words(random, 1) + R"(","indices":[)" + std::to_string(tag * 10) + "," + std::to_string(tag * 10 + 6) + "]}";
+
+            json += R"(]},"retweet_count":)" + std::to_string(random.below(5000)) + "}";
+        }
+
+        json += "]}";
+        return { "strings", { json }, R"({"type":"object","properties":{"statuses":{"type":"array","items":{"type":"object","required":["id","text","user"],"properties":{"text":{"type":"string","minLength":1},"user":{"type":"object","required":["screen_name"]}}}}}})" };
+    }
+
+    // objects and arrays alternating close to the default depth limit
+    Corpus nestedCorpus()
+    {
+        Random random(3);
+        std::string json = "[";
+        for (int tree = 0; tree < 200; tree++)
+        {
+            std::string open, close;
+            for (int depth = 0; depth < 250; depth++)
+            {
+                if (depth % 2)
+                {
+                    open += R"({"level":)" + std::to_string(depth) + R"(,"child":)";
+                    close.insert(close.begin(), '}');
+                }
+                else
+                {
+                    open.append(1, '[').append(std::to_string(random.below(100))).append(1, ',');
+                    close.insert(close.begin(), ']');
+                }
+            }
+
+            json += (tree ? "," : "") + open + "null" + close;
+        }
+
+        json += "]";
+        return { "nested", { json }, R"({"type":"array","items":{"type":"array"}})" };
+    }
+
+    // one object with many keys
+    Corpus wideCorpus()
+    {
+        Random random(4);
+        std::string json = "{";
+        for (int field = 0; field < 50000; field++)
+        {
+            json += std::string(field ? "," : "") + "\"field_" + std::to_string(random.next() % 1000000000) + "_" + std::to_string(field) + "\":";
+            switch (random.below(4))
+            {
+            case 0: json += std::to_string(random.below(1000000)); break;
+            case 1: json += number(random.unit()); break;
+            case 2: json.append(1, '"').append(words(random, 2)).append(1, '"'); break;
+            default: json += (random.below(2) ? "true" : "null"); break;
+            }
+        }
+
+        json += "}";
+        return { "wide", { json }, R"({"type":"object","minProperties":1,"additionalProperties":{"type":["integer","number","string","boolean","null"]}})" };
+    }
+
+    // many small records like lines of ndjson logs
+    Corpus recordsCorpus()
+    {
+        Random random(5);
+        Corpus corpus{ "ndjson", {}, R"({"type":"object","required":["ts","level","message"],"properties":{"level":{"enum":["debug","info","warn","error"]},"latency":{"type":"number","minimum":0}}})" };
+        static const char* levels[] = { "debug", "info", "warn", "error" };
+        for (int line = 0; line < 20000; line++)
+        {
+            corpus.documents.push_back(R"({"ts":)" + std::to_string(1700000000000ULL + line * 17) + R"(,"level":")" + levels[random.below(4)]
+                + R"(","message":")" + words(random, 6) + R"(","latency":)" + number(random.unit() * 250.0)
+                + R"(,"tags":["svc-)" + std::to_string(random.below(12)) + R"(","zone-)" + std::to_string(random.below(3)) + R"("]})");
+        }
+
+        return corpus;
+    }
+
+    class Bench
+    {
+    public:
+        explicit Bench(double minSeconds)
+        : minSeconds_(minSeconds)
+        {
+        }
+
+        // repeats the operation until it has run for the minimal time, prepare is not measured
+        void measure(const Corpus& corpus, const char* operation, const std::function<void()>& prepare, const std::function<void()>& run)
+        {
+            double seconds = 0.0;
+            size_t iterations = 0;
+            while (seconds < minSeconds_ || iterations < 3)
+            {
+                prepare();
+                auto start = std::chrono::steady_clock::now();
+                run();
+                seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+                iterations++;
+            }
+
+            double bytes = double(corpus.bytes) * iterations;
+            double documents = double(corpus.documents.size()) * iterations;
+            results_.push_back(JsonSerialization::VariantMap
+            {
+                { "corpus", corpus.name },
+                { "operation", operation },
+                { "bytes", (unsigned long long)corpus.bytes },
+                { "documents", (unsigned long long)corpus.documents.size() },
+                { "iterations", (unsigned long long)iterations },
+                { "seconds", seconds },
+                { "mbPerSecond", bytes / seconds / 1e6 },
+                { "documentsPerSecond", documents / seconds }
+            });
+        }
+
+        void run(const Corpus& corpus)
+        {
+            std::vector<JsonSerialization::Variant> variants(corpus.documents.size());
+            std::vector<JsonSerialization::Variant> copies(corpus.documents.size());
+            auto parse = [&]()
+            {
+                for (size_t i = 0; i < corpus.documents.size(); i++)
+                {
+                    if (!JsonSerialization::Variant::fromJson(corpus.documents[i], variants[i]))
+                        fail(corpus, "parse");
+                }
+            };
+
+            auto nothing = []() {};
+            auto release = [&]()
+            {
+                for (JsonSerialization::Variant& variant : variants)
+                    variant = JsonSerialization::Variant();
+            };
+
+            measure(corpus, "parse", release, parse);
+            parse();
+
+            JsonSerialization::Parser parser;
+            measure(corpus, "parseReused", release, [&]()
+            {
+                for (size_t i = 0; i < corpus.documents.size(); i++)
+                {
+                    if (!parser.parse(corpus.documents[i], variants[i]))
+                        fail(corpus, "parseReused");
+                }
+            });
+
+            size_t sink = 0;
+            measure(corpus, "serialize", nothing, [&]()
+            {
+                for (const JsonSerialization::Variant& variant : variants)
+                    sink += variant.toJson().size();
+            });
+
+            measure(corpus, "serializePretty", nothing, [&]()
+            {
+                for (const JsonSerialization::Variant& variant : variants)
+                    sink += variant.toJson(true).size();
+            });
+
+            JsonSerialization::Variant schema;
+            if (!JsonSerialization::Variant::fromJson(corpus.schema, schema))
+                fail(corpus, "schema");
+
+            JsonSerialization::ValidationResult result;
+            measure(corpus, "validate", nothing, [&]()
+            {
+                for (const JsonSerialization::Variant& variant : variants)
+                {
+                    result.clear();
+                    if (!JsonSerialization::Variant::validate(schema, variant, result))
+                        fail(corpus, "validate");
+                }
+            });
+
+            auto releaseCopies = [&]()
+            {
+                for (JsonSerialization::Variant& copy : copies)
+                    copy = JsonSerialization::Variant();
+            };
+
+            measure(corpus, "copy", releaseCopies, [&]()
+            {
+                for (size_t i = 0; i < variants.size(); i++)
+                    copies[i] = variants[i];
+            });
+
+            measure(corpus, "destroy", [&]()
+            {
+                for (size_t i = 0; i < variants.size(); i++)
+                    copies[i] = variants[i];
+            }, releaseCopies);
+
+            if (sink == 0)
+                fail(corpus, "serialize");
+        }
+
+        std::string report() const
+        {
+            return JsonSerialization::Variant(JsonSerialization::VariantMap
+            {
+                { "library", "jsonVariant" },
+                { "version", JSON_VARIANT_VERSION },
+                { "minSeconds", minSeconds_ },
+                { "results", results_ }
+            }).toJson(true);
+        }
+
+    private:
+        [[noreturn]] static void fail(const Corpus& corpus, const char* operation)
+        {
+            fprintf(stderr, "Benchmark %s failed on the %s corpus\n", operation, corpus.name.c_str());
+            exit(1);
+        }
+
+        double minSeconds_;
+        JsonSerialization::VariantVector results_;
+    };
+}
+
+int main(int argc, char** argv)
+{
+    double minSeconds = (argc > 1) ? atof(argv[1]) : 0.5;
+    std::string only = (argc > 2) ? argv[2] : "";
+
+    Bench bench(minSeconds);
+    for (Corpus (*make)() : { numbersCorpus, stringsCorpus, nestedCorpus, wideCorpus, recordsCorpus })
+    {
+        Corpus corpus = make();
+        if (!only.empty() && only != corpus.name)
+            continue;
+
+        for (const std::string& document : corpus.documents)
+            corpus.bytes += document.size();
+
+        fprintf(stderr, "%s: %zu documents, %zu bytes\n", corpus.name.c_str(), corpus.documents.size(), corpus.bytes);
+        bench.run(corpus);
+    }
+
+    printf("%s\n", bench.report().c_str());
+    return 0;
+}
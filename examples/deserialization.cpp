@@ -1,4 +1,5 @@
 #include "../include/jsonVariant.h"
+#include "../include/jsonLiteral.h"
 #include "team.h"
 
 #include <fstream>
@@ -31,7 +32,8 @@ namespace
     }
     )");
 
-    std::string validationSchema(R"(
+    // checked by the compiler, a typo in the schema does not build
+    constexpr JsonSerialization::JsonLiteral validationSchema = R"(
     {
         "type": "object",
         "properties": {
@@ -62,14 +64,15 @@ namespace
         },
         "required": ["id", "coach", "address", "players", "identificators" ]
     }
-    )");
+    )";
 }
 
 int main()
 {
     std::string errorStr;
     JsonSerialization::Variant variant;
-    if (!JsonSerialization::Variant::fromJson(jsonString, validationSchema, variant, &errorStr))
+    static const JsonSerialization::CompiledSchema compiledSchema(validationSchema);
+    if (!JsonSerialization::Variant::fromJson(jsonString, compiledSchema, variant, &errorStr))
     {
         printf("Unable to parse json with error: %s", errorStr.c_str());
         return -1;
@@ -97,5 +100,14 @@ int main()
     }
 
     objectMap("identificators").valueVector(team.identificators);
+
+    // or straight into the struct without the variant tree, the fields are declared in team.h
+    Team boundTeam;
+    if (!JsonSerialization::fromJson(jsonString, boundTeam, &errorStr))
+    {
+        printf("Unable to bind json with error: %s", errorStr.c_str());
+        return -1;
+    }
+
     return 1;
 }
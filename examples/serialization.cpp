@@ -46,6 +46,9 @@ int main()
 
     // convert final variant to json string
     printf("%s", JsonSerialization::Variant(variantMap).toJson().c_str());
+
+    // or directly from the struct without the variant tree, the fields are declared in team.h
+    printf("%s", JsonSerialization::toJson(team).c_str());
     
     return 1;
 }
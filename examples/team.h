@@ -1,6 +1,8 @@
 #ifndef __TEAM_H
 #define __TEAM_H
 
+#include "../include/jsonBinding.h"
+
 struct Team
 {
 	struct Player
@@ -24,4 +26,29 @@ struct Team
 	std::vector<int> identificators;
 };
 
+template <> struct JsonSerialization::Binding<Team::Player>
+{
+    static constexpr auto fields = std::make_tuple(
+        JSON_FIELD(Team::Player, name),
+        JSON_FIELD(Team::Player, averageScoring));
+};
+
+template <> struct JsonSerialization::Binding<Team::Address>
+{
+    static constexpr auto fields = std::make_tuple(
+        JSON_FIELD(Team::Address, city),
+        JSON_FIELD(Team::Address, country));
+};
+
+template <> struct JsonSerialization::Binding<Team>
+{
+    static constexpr auto fields = std::make_tuple(
+        JSON_FIELD(Team, id),
+        JSON_FIELD(Team, coach),
+        JSON_FIELD(Team, assistant),
+        JSON_FIELD(Team, address),
+        JSON_FIELD(Team, players),
+        JSON_FIELD(Team, identificators));
+};
+
 #endif
@@ -0,0 +1,573 @@
+#ifndef __JSON_BINDING_H
+#define __JSON_BINDING_H
+
+#include <array>
+#include <bit>
+#include <charconv>
+#include <cmath>
+#include <concepts>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Binding of C++ structs to json without building a Variant tree, a struct declares its fields once
+//
+//     template <> struct JsonSerialization::Binding<Team::Player>
+//     {
+//         static constexpr auto fields = std::make_tuple(
+//             JSON_FIELD(Team::Player, name),
+//             JSON_FIELD(Team::Player, averageScoring));
+//     };
+//
+// and is read with JsonSerialization::fromJson(jsonStr, player) and written with JsonSerialization::toJson(player).
+// Fields may be bools, numbers, strings, other bound structs and vectors of them, keys missing in the json or holding
+// null leave the field untouched, unknown keys are skipped. Strings keep their escape sequences exactly as the Variant
+// parser does and are written back unchanged, so string fields hold json escaped text and writing one with an unescaped
+// quote, backslash or control character throws. Fields are written in the order of their declaration.
+
+#define JSON_FIELD(type, member) JsonSerialization::field(#member, &type::member)
+
+namespace JsonSerialization
+{
+    template <typename T> struct Binding;
+
+    template <typename T> concept Bound = requires { Binding<T>::fields; };
+
+    template <typename C, typename M> struct Field
+    {
+        std::string_view name;
+        M C::* pMember;
+    };
+
+    template <typename C, typename M> constexpr Field<C, M> field(std::string_view name, M C::* pMember)
+    {
+        return Field<C, M>{ name, pMember };
+    }
+}
+
+namespace JsonSerializationInternal
+{
+    constexpr uint32_t hashFieldName(std::string_view name, uint32_t seed)
+    {
+        uint32_t hash = 2166136261u ^ seed;
+        for (char c : name)
+        {
+            hash ^= (uint8_t)c;
+            hash *= 16777619u;
+        }
+
+        // the low bits of FNV only depend on the low bits of the input, mix the high ones down
+        return hash ^ (hash >> 16);
+    }
+
+    // collision free table from field names to field indexes, the seed is searched for at compile time
+    template <size_t N> struct FieldIndex
+    {
+        static constexpr size_t tableSize = std::bit_ceil(N * 2 + 1);
+
+        uint32_t seed = 0;
+        std::array<int, tableSize> slots{};
+
+        constexpr int find(std::string_view name, const std::array<std::string_view, N>& names) const
+        {
+            int index = slots[hashFieldName(name, seed) & (tableSize - 1)];
+            if (index >= 0 && names[index] == name)
+                return index;
+
+            return -1;
+        }
+    };
+
+    template <size_t N> constexpr FieldIndex<N> makeFieldIndex(const std::array<std::string_view, N>& names)
+    {
+        FieldIndex<N> fieldIndex;
+        for (uint32_t seed = 0; seed < 4096; seed++)
+        {
+            fieldIndex.seed = seed;
+            fieldIndex.slots.fill(-1);
+            bool collision = false;
+            for (size_t i = 0; i < N && !collision; i++)
+            {
+                int& slot = fieldIndex.slots[hashFieldName(names[i], seed) & (FieldIndex<N>::tableSize - 1)];
+                if (slot >= 0)
+                    collision = true;
+                else
+                    slot = (int)i;
+            }
+
+            if (!collision)
+                return fieldIndex;
+        }
+
+        throw std::logic_error("Duplicate field names in binding");
+    }
+
+    template <typename T> struct BindingInfo
+    {
+        static constexpr size_t size = std::tuple_size_v<std::remove_cvref_t<decltype(JsonSerialization::Binding<T>::fields)>>;
+
+        template <size_t... I> static constexpr std::array<std::string_view, size> namesOf(std::index_sequence<I...>)
+        {
+            return { std::get<I>(JsonSerialization::Binding<T>::fields).name... };
+        }
+
+        static constexpr std::array<std::string_view, size> names = namesOf(std::make_index_sequence<size>());
+        static constexpr FieldIndex<size> index = makeFieldIndex(names);
+
+        // every key with its quotes and colon and the '{' or ',' in front of it, written with a single append
+        static constexpr size_t keysSize = []
+        {
+            size_t keysSize = 0;
+            for (std::string_view name : names)
+                keysSize += name.size() + 4;
+
+            return keysSize;
+        }();
+
+        struct KeyLiterals
+        {
+            std::array<char, keysSize> text{};
+            std::array<size_t, size + 1> offsets{};
+
+            constexpr std::string_view operator[](size_t i) const
+            {
+                return std::string_view(text.data() + offsets[i], offsets[i + 1] - offsets[i]);
+            }
+        };
+
+        static constexpr KeyLiterals keys = []
+        {
+            KeyLiterals keys;
+            size_t pos = 0;
+            for (size_t i = 0; i < size; i++)
+            {
+                keys.offsets[i] = pos;
+                keys.text[pos++] = (i == 0) ? '{' : ',';
+                keys.text[pos++] = '\"';
+                for (char c : names[i])
+                    keys.text[pos++] = c;
+
+                keys.text[pos++] = '\"';
+                keys.text[pos++] = ':';
+            }
+
+            keys.offsets[size] = pos;
+            return keys;
+        }();
+    };
+
+    class BindingReader
+    {
+    public:
+        BindingReader(const char* pData, const char* pEnd)
+        : pData_(pData), pEnd_(pEnd)
+        {
+        }
+
+        template <typename T> void readDocument(T& value)
+        {
+            read(value);
+            skipWhitespace();
+            if (pData_ != pEnd_)
+                throw std::runtime_error("Unexpected data after json value");
+        }
+
+        template <typename T> void read(T& value)
+        {
+            skipWhitespace();
+            if (peek() == 'n')
+                return readNull();
+
+            readValue(value);
+        }
+
+    private:
+        void readValue(bool& value)
+        {
+            if (matchLiteral("true"))
+                value = true;
+            else if (matchLiteral("false"))
+                value = false;
+            else
+                throw std::runtime_error("Unable to parse boolean value");
+        }
+
+        template <typename T> requires (std::is_arithmetic_v<T> && !std::is_same_v<T, bool>)
+        void readValue(T& value)
+        {
+            const char* pStart = pData_;
+            while (pData_ != pEnd_ && (isdigit(*pData_) || *pData_ == '-' || *pData_ == '+' || *pData_ == '.' || *pData_ == 'e' || *pData_ == 'E'))
+                ++pData_;
+
+            if (pStart == pData_)
+                throw std::runtime_error("Unknown character when parsing value");
+
+            auto result = std::from_chars(pStart, pData_, value);
+            if (result.ec == std::errc::result_out_of_range)
+                throw std::runtime_error("Out of range value when number converting");
+
+            if (result.ec != std::errc() || result.ptr != pData_)
+                throw std::runtime_error("Invalid argument when number converting");
+        }
+
+        void readValue(std::string& value)
+        {
+            expect('\"', "Expected string value");
+            value = readString("Not finished string value reading");
+        }
+
+        template <typename T> void readValue(std::vector<T>& value)
+        {
+            expect('[', "Expected array value");
+            value.clear();
+            skipWhitespace();
+            if (peek() == ']')
+            {
+                ++pData_;
+                return;
+            }
+
+            for (;;)
+            {
+                read(value.emplace_back());
+                skipWhitespace();
+                char c = peek();
+                ++pData_;
+                if (c == ']')
+                    return;
+
+                if (c != ',')
+                    throw std::runtime_error("Missing delimiter");
+            }
+        }
+
+        template <JsonSerialization::Bound T> void readValue(T& value)
+        {
+            expect('{', "Expected object value");
+            skipWhitespace();
+            if (peek() == '}')
+            {
+                ++pData_;
+                return;
+            }
+
+            for (;;)
+            {
+                skipWhitespace();
+                std::string_view key = readKey();
+                skipWhitespace();
+                expect(':', "Expected value delimiter");
+                readField(value, key);
+                skipWhitespace();
+                char c = peek();
+                ++pData_;
+                if (c == '}')
+                    return;
+
+                if (c != ',')
+                    throw std::runtime_error("Missing delimiter");
+            }
+        }
+
+        template <typename T> void readField(T& value, std::string_view key)
+        {
+            using Info = BindingInfo<T>;
+            int index = Info::index.find(key, Info::names);
+            if (index < 0)
+                return skipValue();
+
+            static constexpr auto readers = fieldReaders<T>(std::make_index_sequence<Info::size>());
+            readers[index](*this, value);
+        }
+
+        template <typename T, size_t... I> static constexpr auto fieldReaders(std::index_sequence<I...>)
+        {
+            typedef void (*FieldReader)(BindingReader& reader, T& value);
+            return std::array<FieldReader, sizeof...(I)>
+            {
+                [](BindingReader& reader, T& value) { reader.read(value.*(std::get<I>(JsonSerialization::Binding<T>::fields).pMember)); }...
+            };
+        }
+
+        std::string_view readKey()
+        {
+            expect('\"', "Expected key");
+            return readString("Missing end of the key");
+        }
+
+        // the characters after the opening quote up to the closing one, which is consumed, escapes are kept as written
+        std::string_view readString(const char* unfinishedMessage)
+        {
+            const char* pStart = pData_;
+            while (pData_ != pEnd_ && *pData_ != '\"')
+            {
+                if (*pData_ == '\\')
+                {
+                    ++pData_;
+                    if (pData_ == pEnd_ || std::string_view("\"\\nrtbf").find(*pData_) == std::string_view::npos)
+                        throw std::runtime_error("Incorrect escaping in string value reading");
+                }
+
+                ++pData_;
+            }
+
+            if (pData_ == pEnd_)
+                throw std::runtime_error(unfinishedMessage);
+
+            return std::string_view(pStart, pData_++ - pStart);
+        }
+
+        void skipValue()
+        {
+            // values of unknown keys are checked as strictly as the others, the open containers are kept on a stack
+            // of their end characters so deep nesting does not recurse
+            std::string endChars;
+            for (;;)
+            {
+                skipWhitespace();
+                char c = peek();
+                if (c == '{' || c == '[')
+                {
+                    char endChar = (c == '{') ? '}' : ']';
+                    ++pData_;
+                    skipWhitespace();
+                    if (peek() != endChar)
+                    {
+                        endChars.push_back(endChar);
+                        if (c == '{')
+                            skipKey();
+
+                        continue;
+                    }
+
+                    ++pData_;
+                }
+                else
+                    skipScalar(c);
+
+                // the finished value may finish its containers as well
+                for (;;)
+                {
+                    if (endChars.empty())
+                        return;
+
+                    skipWhitespace();
+                    char next = peek();
+                    ++pData_;
+                    if (next == endChars.back())
+                    {
+                        endChars.pop_back();
+                        continue;
+                    }
+
+                    if (next != ',')
+                        throw std::runtime_error("Missing delimiter");
+
+                    if (endChars.back() == '}')
+                        skipKey();
+
+                    break;
+                }
+            }
+        }
+
+        void skipKey()
+        {
+            skipWhitespace();
+            readKey();
+            skipWhitespace();
+            expect(':', "Expected value delimiter");
+        }
+
+        void skipScalar(char c)
+        {
+            if (c == '\"')
+            {
+                ++pData_;
+                readString("Not finished string value reading");
+            }
+            else if (c == 't' || c == 'f')
+            {
+                bool ignored;
+                readValue(ignored);
+            }
+            else if (c == 'n')
+                readNull();
+            else
+            {
+                double ignored;
+                readValue(ignored);
+            }
+        }
+
+        void readNull()
+        {
+            if (!matchLiteral("null"))
+                throw std::runtime_error("Unable to parse null value");
+        }
+
+        bool matchLiteral(std::string_view literal)
+        {
+            if ((size_t)(pEnd_ - pData_) < literal.size() || std::string_view(pData_, literal.size()) != literal)
+                return false;
+
+            pData_ += literal.size();
+            return true;
+        }
+
+        void skipWhitespace()
+        {
+            while (pData_ != pEnd_ && (*pData_ == ' ' || *pData_ == '\n' || *pData_ == '\t' || *pData_ == '\r'))
+                ++pData_;
+        }
+
+        char peek() const
+        {
+            if (pData_ == pEnd_)
+                throw std::runtime_error("Unexpected end of json");
+
+            return *pData_;
+        }
+
+        void expect(char c, const char* message)
+        {
+            if (peek() != c)
+                throw std::runtime_error(message);
+
+            ++pData_;
+        }
+
+        static bool isdigit(char c)
+        {
+            return c >= '0' && c <= '9';
+        }
+
+        const char* pData_;
+        const char* pEnd_;
+    };
+
+    class BindingWriter
+    {
+    public:
+        explicit BindingWriter(std::string& out)
+        : out_(out)
+        {
+        }
+
+        void write(bool value)
+        {
+            out_.append(value ? "true" : "false");
+        }
+
+        template <typename T> requires (std::is_arithmetic_v<T> && !std::is_same_v<T, bool>)
+        void write(T value)
+        {
+            if constexpr (std::is_floating_point_v<T>)
+            {
+                if (!std::isfinite(value))
+                    return (void)out_.append("null");
+            }
+
+            char buffer[32];
+            auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+            out_.append(buffer, result.ptr);
+        }
+
+        void write(const std::string& value)
+        {
+            // the text is json escaped already, anything that would end the string or break the json is refused
+            for (size_t i = 0; i < value.size(); i++)
+            {
+                if (value[i] == '\\')
+                {
+                    if (++i == value.size() || std::string_view("\"\\nrtbf").find(value[i]) == std::string_view::npos)
+                        throw std::runtime_error("Incorrect escaping in string value writing");
+                }
+                else if (value[i] == '\"' || (uint8_t)value[i] < 0x20)
+                    throw std::runtime_error("Unescaped character in string value writing");
+            }
+
+            out_.push_back('\"');
+            out_.append(value);
+            out_.push_back('\"');
+        }
+
+        template <typename T> void write(const std::vector<T>& value)
+        {
+            out_.push_back('[');
+            for (size_t i = 0; i < value.size(); i++)
+            {
+                if (i > 0)
+                    out_.push_back(',');
+
+                write(value[i]);
+            }
+
+            out_.push_back(']');
+        }
+
+        template <JsonSerialization::Bound T> void write(const T& value)
+        {
+            using Info = BindingInfo<T>;
+            if constexpr (Info::size == 0)
+                out_.append("{}");
+            else
+            {
+                writeFields(value, std::make_index_sequence<Info::size>());
+                out_.push_back('}');
+            }
+        }
+
+    private:
+        template <typename T, size_t... I> void writeFields(const T& value, std::index_sequence<I...>)
+        {
+            using Info = BindingInfo<T>;
+            ((out_.append(Info::keys[I]), write(value.*(std::get<I>(JsonSerialization::Binding<T>::fields).pMember))), ...);
+        }
+
+        std::string& out_;
+    };
+}
+
+namespace JsonSerialization
+{
+    // parses json directly into a bound struct, a vector of them or a plain value
+    template <typename T> bool fromJson(std::string_view jsonStr, T& value, std::string* errorStr = nullptr)
+    {
+        try
+        {
+            JsonSerializationInternal::BindingReader reader(jsonStr.data(), jsonStr.data() + jsonStr.size());
+            reader.readDocument(value);
+        }
+        catch (const std::exception& e)
+        {
+            if (errorStr)
+                *errorStr = e.what();
+
+            return false;
+        }
+
+        return true;
+    }
+
+    // appends the json of a bound struct, a vector of them or a plain value to out, keeps its capacity for reuse
+    template <typename T> void toJson(const T& value, std::string& out)
+    {
+        JsonSerializationInternal::BindingWriter writer(out);
+        writer.write(value);
+    }
+
+    template <typename T> std::string toJson(const T& value)
+    {
+        std::string out;
+        toJson(value, out);
+        return out;
+    }
+}
+
+#endif
@@ -0,0 +1,408 @@
+#ifndef __JSON_LITERAL_H
+#define __JSON_LITERAL_H
+
+#include "jsonVariant.h"
+
+#include <array>
+#include <cstdint>
+#include <stdexcept>
+#include <string_view>
+
+// Json embedded in the program checked by the compiler, a malformed literal is a compile error instead of a failure
+// at startup
+//
+//     constexpr JsonSerialization::JsonLiteral teamSchema = R"({"type": "object", "required": ["id"]})";
+//     static const JsonSerialization::CompiledSchema compiledTeamSchema(teamSchema);
+//
+// The grammar is the one of Variant::parse with the default ParseOptions. The tree itself is still built at run time
+// because variants own heap blocks, a CompiledSchema keeps the parsed and prepared schema so it is done once.
+
+namespace JsonSerializationInternal
+{
+    // significant decimal digits of a bound of the double range, the first one at 10^exponent
+    struct DecimalBound
+    {
+        std::array<char, 760> digits{};
+        size_t size = 0;
+        int64_t exponent = 0;
+    };
+
+    // factor * base^power * 10^scale, the digits are exact so from_chars can be matched at the rounding boundaries
+    constexpr DecimalBound decimalBound(uint64_t factor, uint64_t base, int power, int64_t scale)
+    {
+        // limbs of 9 decimal digits, least significant first, multipliers stay below 2^34 so products fit 64 bits
+        constexpr uint64_t limbBase = 1000000000;
+        std::array<uint64_t, 90> limbs{};
+        size_t count = 0;
+        for (; factor > 0; factor /= limbBase)
+            limbs[count++] = factor % limbBase;
+
+        while (power > 0)
+        {
+            uint64_t multiplier = 1;
+            for (; power > 0 && multiplier * base < (uint64_t(1) << 34); power--)
+                multiplier *= base;
+
+            uint64_t carry = 0;
+            for (size_t i = 0; i < count; i++)
+            {
+                uint64_t value = limbs[i] * multiplier + carry;
+                limbs[i] = value % limbBase;
+                carry = value / limbBase;
+            }
+
+            for (; carry > 0; carry /= limbBase)
+                limbs[count++] = carry % limbBase;
+        }
+
+        DecimalBound bound;
+        for (size_t i = count; i-- > 0;)
+        {
+            std::array<char, 9> limbDigits{};
+            for (size_t j = 9; j-- > 0; limbs[i] /= 10)
+                limbDigits[j] = char('0' + limbs[i] % 10);
+
+            size_t first = 0;
+            while (i == count - 1 && limbDigits[first] == '0')
+                first++;
+
+            for (size_t j = first; j < 9; j++)
+                bound.digits[bound.size++] = limbDigits[j];
+        }
+
+        bound.exponent = (int64_t)bound.size - 1 + scale;
+        return bound;
+    }
+
+    // from_chars rounds to infinity from 2^1024 - 2^970 up and to zero from 2^-1075 down, both are out of range
+    inline constexpr DecimalBound overflowBound = decimalBound((uint64_t(1) << 54) - 1, 2, 970, 0);
+    inline constexpr DecimalBound underflowBound = decimalBound(1, 5, 1075, -1075);
+
+    // the checks of JsonParser in a constant expression, nothing is built and errors are at the same positions
+    class LiteralChecker
+    {
+    public:
+        constexpr explicit LiteralChecker(std::string_view text) : text_(text) {}
+
+        constexpr JsonSerialization::ParseResult check()
+        {
+            using JsonSerialization::ParseErrorCode;
+
+            std::array<char, maxDepth> endChars{};
+            size_t depth = 0;
+            skipWhitespace();
+            if (peek() != '{' && peek() != '[')
+                return fail(ParseErrorCode::InvalidRoot);
+
+            for (;;)
+            {
+                char c = peek();
+                if (c == '{' || c == '[')
+                {
+                    if (depth >= maxDepth)
+                        return fail(ParseErrorCode::NestingTooDeep);
+
+                    endChars[depth++] = (c == '{') ? '}' : ']';
+                    ++pos_;
+                    skipWhitespace();
+                    if (peek() == endChars[depth - 1])
+                    {
+                        ++pos_;
+                        --depth;
+                    }
+                    else if (c == '{' && !key())
+                        return result_;
+                    else
+                        continue;
+                }
+                else if (!scalar())
+                {
+                    return result_;
+                }
+
+                // the finished value may finish its containers as well
+                for (;;)
+                {
+                    skipWhitespace();
+                    if (depth == 0)
+                        return (pos_ == text_.size()) ? result_ : fail(ParseErrorCode::TrailingCharacters);
+
+                    char next = peek();
+                    if (next == endChars[depth - 1])
+                    {
+                        ++pos_;
+                        --depth;
+                        continue;
+                    }
+
+                    if (next != ',')
+                        return fail(ParseErrorCode::MissingDelimiter);
+
+                    ++pos_;
+                    skipWhitespace();
+                    if (endChars[depth - 1] == '}' && !key())
+                        return result_;
+
+                    break;
+                }
+            }
+        }
+
+    private:
+        static constexpr size_t maxDepth = JsonSerialization::ParseOptions().maxDepth;
+
+        static constexpr bool isDigit(char c) { return c >= '0' && c <= '9'; }
+
+        constexpr char peek() const { return pos_ < text_.size() ? text_[pos_] : '\0'; }
+
+        constexpr void skipWhitespace()
+        {
+            while (pos_ < text_.size() && (text_[pos_] == ' ' || text_[pos_] == '\n' || text_[pos_] == '\t' || text_[pos_] == '\r'))
+                ++pos_;
+        }
+
+        constexpr JsonSerialization::ParseResult fail(JsonSerialization::ParseErrorCode code, size_t pos)
+        {
+            result_.code = (pos < text_.size()) ? code : JsonSerialization::ParseErrorCode::UnfinishedDocument;
+            result_.offset = pos;
+            result_.line = 1;
+            size_t lineStart = 0;
+            for (size_t i = 0; i < pos; i++)
+            {
+                if (text_[i] == '\n')
+                {
+                    result_.line++;
+                    lineStart = i + 1;
+                }
+            }
+
+            result_.column = pos - lineStart + 1;
+            return result_;
+        }
+
+        constexpr JsonSerialization::ParseResult fail(JsonSerialization::ParseErrorCode code) { return fail(code, pos_); }
+        constexpr bool failed(JsonSerialization::ParseErrorCode code, size_t pos) { fail(code, pos); return false; }
+        constexpr bool failed(JsonSerialization::ParseErrorCode code) { return failed(code, pos_); }
+
+        constexpr bool string()
+        {
+            // escapes are kept verbatim by the parser, only the escaped character is checked
+            size_t start = pos_++;
+            while (pos_ < text_.size())
+            {
+                char c = text_[pos_];
+                if (c == '\"')
+                {
+                    ++pos_;
+                    return true;
+                }
+
+                if (c == '\\')
+                {
+                    char escaped = (pos_ + 1 < text_.size()) ? text_[pos_ + 1] : '\0';
+                    if (escaped != '"' && escaped != '\\' && escaped != 'n' && escaped != 'r' && escaped != 't' && escaped != 'b' && escaped != 'f')
+                        return failed(JsonSerialization::ParseErrorCode::InvalidEscape);
+
+                    ++pos_;
+                }
+
+                ++pos_;
+            }
+
+            return failed(JsonSerialization::ParseErrorCode::UnfinishedString, start);
+        }
+
+        constexpr bool key()
+        {
+            if (peek() != '\"')
+                return failed(JsonSerialization::ParseErrorCode::InvalidKey);
+
+            if (!string())
+                return false;
+
+            skipWhitespace();
+            if (peek() != ':')
+                return failed(JsonSerialization::ParseErrorCode::MissingColon);
+
+            ++pos_;
+            skipWhitespace();
+            return true;
+        }
+
+        constexpr bool literal()
+        {
+            std::string_view rest = text_.substr(pos_);
+            for (std::string_view name : { std::string_view("true"), std::string_view("false"), std::string_view("null") })
+            {
+                if (rest.starts_with(name))
+                {
+                    pos_ += name.size();
+                    return true;
+                }
+            }
+
+            return failed(JsonSerialization::ParseErrorCode::InvalidLiteral);
+        }
+
+        // -1, 0 or 1 for the significant digits, a '.' among them is skipped, at 10^exponent against the bound
+        static constexpr int compareMagnitude(std::string_view digits, int64_t exponent, const DecimalBound& bound)
+        {
+            if (exponent != bound.exponent)
+                return exponent < bound.exponent ? -1 : 1;
+
+            size_t i = 0;
+            for (char c : digits)
+            {
+                if (c == '.')
+                    continue;
+
+                if (i == bound.size)
+                {
+                    if (c != '0')
+                        return 1;
+
+                    continue;
+                }
+
+                if (c != bound.digits[i])
+                    return c < bound.digits[i] ? -1 : 1;
+
+                i++;
+            }
+
+            for (; i < bound.size; i++)
+            {
+                if (bound.digits[i] != '0')
+                    return -1;
+            }
+
+            return 0;
+        }
+
+        constexpr bool number()
+        {
+            // the syntax from_chars accepts, the range by the exact bounds it rounds to infinity or zero from
+            size_t start = pos_;
+            if (peek() == '-')
+                ++pos_;
+
+            int64_t exponent = -1;
+            bool significant = false;
+            size_t firstSignificant = 0;
+            size_t digits = 0;
+            for (; isDigit(peek()); ++pos_, ++digits)
+            {
+                firstSignificant = significant ? firstSignificant : pos_;
+                significant = significant || peek() != '0';
+                exponent += significant ? 1 : 0;
+            }
+
+            if (peek() == '.')
+            {
+                for (++pos_; isDigit(peek()); ++pos_, ++digits)
+                {
+                    firstSignificant = significant ? firstSignificant : pos_;
+                    significant = significant || peek() != '0';
+                    exponent -= significant ? 0 : 1;
+                }
+            }
+
+            std::string_view mantissa = significant ? text_.substr(firstSignificant, pos_ - firstSignificant) : std::string_view();
+
+            bool valid = (digits > 0);
+            if (peek() == 'e' || peek() == 'E')
+            {
+                ++pos_;
+                bool negative = (peek() == '-');
+                if (peek() == '+' || peek() == '-')
+                    ++pos_;
+
+                int64_t value = 0;
+                valid = valid && isDigit(peek());
+                for (; isDigit(peek()); ++pos_)
+                    value = (value < 100000) ? value * 10 + (peek() - '0') : value;
+
+                exponent += negative ? -value : value;
+            }
+
+            if (!valid)
+                return failed(JsonSerialization::ParseErrorCode::InvalidNumber, start);
+
+            if (significant && (compareMagnitude(mantissa, exponent, overflowBound) >= 0 || compareMagnitude(mantissa, exponent, underflowBound) <= 0))
+                return failed(JsonSerialization::ParseErrorCode::NumberOutOfRange, start);
+
+            return true;
+        }
+
+        constexpr bool scalar()
+        {
+            char c = peek();
+            if (c == '\"')
+                return string();
+
+            if (c == 't' || c == 'f' || c == 'n')
+                return literal();
+
+            if (isDigit(c) || c == '-')
+                return number();
+
+            return failed(JsonSerialization::ParseErrorCode::UnexpectedCharacter);
+        }
+
+        std::string_view text_;
+        size_t pos_ = 0;
+        JsonSerialization::ParseResult result_;
+    };
+}
+
+namespace JsonSerialization
+{
+    // result Variant::parse would give for the text with the default options, in constant expressions too
+    constexpr ParseResult checkJson(std::string_view text)
+    {
+        return JsonSerializationInternal::LiteralChecker(text).check();
+    }
+
+    class JsonLiteral
+    {
+    public:
+        template <size_t N> consteval JsonLiteral(const char (&text)[N])
+        : JsonLiteral(std::string_view(text, N - 1))
+        {
+        }
+
+        consteval explicit JsonLiteral(std::string_view text)
+        : text_(text)
+        {
+            if (!checkJson(text))
+                throw std::invalid_argument("Malformed json literal");
+        }
+
+        constexpr std::string_view text() const { return text_; }
+        constexpr operator std::string_view() const { return text_; }
+
+        // a new tree at every call, it fails only without memory or with tighter options than the default ones
+        Variant variant(const ParseOptions& options = ParseOptions()) const
+        {
+            Variant jsonVariant;
+            ParseResult result = Variant::parse(text_, jsonVariant, options);
+            if (!result)
+                throw std::runtime_error(result.toString());
+
+            return jsonVariant;
+        }
+
+    private:
+        std::string_view text_;
+    };
+
+    namespace Literals
+    {
+        consteval JsonLiteral operator""_json(const char* text, size_t size)
+        {
+            return JsonLiteral(std::string_view(text, size));
+        }
+    }
+}
+
+#endif
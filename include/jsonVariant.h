@@ -4,6 +4,32 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <compare>
+#include <coroutine>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+namespace JsonSerializationInternal
+{
+    class PreparedSchema;
+#ifdef JSON_VARIANT_STATS
+    extern thread_local size_t collectingOperations;   // instrumented operations running on the calling thread
+    void countAllocation(size_t bytes) noexcept;
+#endif
+}
 
 namespace JsonSerialization
 {
@@ -15,13 +41,435 @@ namespace JsonSerialization
         Bool,
         String,
         Vector,
-        Map
+        Map,
+        NumberArray,    // flat array of doubles or int64 values, see ParseOptions::typedArrays
+        Record          // object stored as a shared Shape and its values, see ParseOptions::shareShapes
+    };
+
+    // storage of a Type::Number value, integral literals are kept exactly
+    enum class NumberType : char
+    {
+        Double,
+        Int64,
+        UInt64
+    };
+
+    enum class ValidationErrorCode : char
+    {
+        None,
+        InvalidSchema,
+        Type,
+        Required,
+        MinProperties,
+        MaxProperties,
+        Items,
+        MinItems,
+        MaxItems,
+        MinContains,
+        MaxContains,
+        UniqueItems,
+        MinLength,
+        MaxLength,
+        Pattern,
+        Format,
+        Minimum,
+        Maximum,
+        ExclusiveMinimum,
+        ExclusiveMaximum,
+        MultipleOf,
+        Enum,
+        Const,
+        AnyOf,
+        OneOf,
+        Not,
+        AdditionalProperties,
+        DependentRequired
+    };
+
+    enum class ParseErrorCode : char
+    {
+        None,
+        InvalidRoot,            // document is not an object or an array
+        UnexpectedCharacter,    // no value starts with the character
+        InvalidKey,             // object member does not start with a quoted key
+        MissingColon,
+        MissingDelimiter,       // value is not followed by a comma or the end of its container
+        UnfinishedString,
+        InvalidEscape,
+        InvalidLiteral,         // misspelled true, false or null
+        InvalidNumber,
+        NumberOutOfRange,
+        UnfinishedDocument,     // input ends inside a container
+        TrailingCharacters,     // something else than whitespace follows the document
+        NestingTooDeep,         // more containers are nested than ParseOptions::maxDepth
+        DocumentTooLarge,       // input is longer than ParseOptions::maxDocumentSize
+        FileError,              // file could not be opened or mapped
+        OutOfMemory
+    };
+
+    // outcome of the exception free parsing, the position points at the first character which could not be parsed
+    struct ParseResult
+    {
+        ParseErrorCode code = ParseErrorCode::None;
+        size_t offset = 0;      // byte offset in the input
+        size_t line = 0;        // line and column count from 1, they are 0 without a position in the input
+        size_t column = 0;
+
+        constexpr explicit operator bool() const { return code == ParseErrorCode::None; }
+        const char* message() const;
+        std::string toString() const;
+    };
+
+    struct ValidationError
+    {
+        ValidationErrorCode code = ValidationErrorCode::None;
+        const char* keyword = "";   // failing schema keyword
+        const char* message = "";
+        std::string path;           // json pointer to the failing node
+
+        std::string toString() const;
+    };
+
+    // result of the schema validation, it is meant to be kept and reused, clear() keeps all allocated error records
+    class ValidationResult
+    {
+    public:
+        explicit ValidationResult(bool collectAll = false, size_t capacity = 0);
+
+        bool isValid() const;
+        bool collectAll() const;
+        void setCollectAll(bool collectAll);
+        size_t size() const;
+        const ValidationError& operator[](size_t index) const;
+        std::span<const ValidationError> errors() const;
+        void clear();
+        void reserve(size_t capacity);
+        void add(ValidationErrorCode code, const char* keyword, const char* message, const std::string& path);
+        void append(const ValidationResult& other);
+
+    private:
+        std::vector<ValidationError> errors_;
+        size_t size_;
+        bool collectAll_;
+    };
+
+    struct SchemaCacheStats
+    {
+        uint64_t hits;
+        uint64_t misses;
+        uint64_t evictions;
+        size_t size;
+        size_t capacity;
+    };
+
+    // schemas passed as text to fromJson are parsed and prepared once and kept in a process wide cache
+    class SchemaCache
+    {
+    public:
+        static void setCapacity(size_t capacity);   // 0 disables caching
+        static size_t capacity();
+        static SchemaCacheStats stats();
+        static void clear();
+    };
+
+    enum class Operation : char
+    {
+        Parse,
+        Validate,
+        Serialize
+    };
+
+    struct OperationStats
+    {
+        static constexpr size_t typeCount = size_t(Type::Record) + 1;
+
+        Operation operation = Operation::Parse;
+        bool succeeded = false;
+        size_t bytes = 0;               // json parsed or written
+        size_t nodes[typeCount] = {};   // values of the document by their Type
+        size_t maxDepth = 0;
+        size_t allocations = 0;         // value blocks allocated by the operation, with their sizes
+        size_t allocatedBytes = 0;
+        std::chrono::nanoseconds elapsed{ 0 };
+    };
+
+    // statistics of parsing, validation and serialization, they exist only in builds with JSON_VARIANT_STATS and are
+    // collected only while a callback is set, the callback is called on the thread which ran the operation
+    class Instrumentation
+    {
+    public:
+        typedef std::function<void(const OperationStats& stats)> Callback;
+
+#ifdef JSON_VARIANT_STATS
+        static constexpr bool compiledIn = true;
+#else
+        static constexpr bool compiledIn = false;
+#endif
+
+        static void setCallback(Callback callback);     // an empty callback disables collecting
+        static bool enabled();
+        static OperationStats lastStats();              // of the last operation of the calling thread
+    };
+
+    // memory resource of everything variants allocate on the calling thread while the scope is alive, the value blocks,
+    // the characters of strings and keys, the elements of vectors and typed arrays and the nodes of maps, scopes nest
+    // and the innermost one wins, without any scope the global operator new is used, memory goes back to the resource
+    // it came from on whatever thread it is released, so the resource has to be thread safe if variants are handed
+    // over and it has to outlive all of them, keys are shared rather than copied so copies keep them in the resource
+    class MemoryScope
+    {
+    public:
+        explicit MemoryScope(std::pmr::memory_resource* pResource) noexcept;   // null selects the global operator new
+        ~MemoryScope();
+        MemoryScope(const MemoryScope&) = delete;
+        MemoryScope& operator=(const MemoryScope&) = delete;
+
+        static std::pmr::memory_resource* current() noexcept;
+
+    private:
+        std::pmr::memory_resource* pPrevious_;
+    };
+
+    // allocator of the strings and containers of variants, it keeps the resource of the MemoryScope current when it
+    // was made, copied containers take the one current at the copy and moved ones carry theirs along
+    template <typename T> class ScopedAllocator
+    {
+    public:
+        using value_type = T;
+        using propagate_on_container_move_assignment = std::true_type;
+        using propagate_on_container_swap = std::true_type;
+        using is_always_equal = std::false_type;
+
+        ScopedAllocator() noexcept : pResource_(MemoryScope::current()) {}
+        explicit ScopedAllocator(std::pmr::memory_resource* pResource) noexcept : pResource_(pResource) {}
+        template <typename U> ScopedAllocator(const ScopedAllocator<U>& allocator) noexcept : pResource_(allocator.resource()) {}
+
+        T* allocate(size_t count)
+        {
+            if (pResource_)
+                return static_cast<T*>(pResource_->allocate(count * sizeof(T), alignof(T)));
+
+            return static_cast<T*>(::operator new(count * sizeof(T)));
+        }
+
+        void deallocate(T* p, size_t count) noexcept
+        {
+            if (pResource_)
+                pResource_->deallocate(p, count * sizeof(T), alignof(T));
+            else
+                ::operator delete(p);
+        }
+
+        ScopedAllocator select_on_container_copy_construction() const { return ScopedAllocator(); }
+        std::pmr::memory_resource* resource() const noexcept { return pResource_; }
+        template <typename U> bool operator==(const ScopedAllocator<U>& allocator) const noexcept { return pResource_ == allocator.resource(); }
+
+    private:
+        std::pmr::memory_resource* pResource_;
+    };
+
+    // characters of a Type::String or a Key, a std::basic_string allocated like the containers which converts to
+    // std::string and compares with it
+    struct VariantString : std::basic_string<char, std::char_traits<char>, ScopedAllocator<char>>
+    {
+        using std::basic_string<char, std::char_traits<char>, ScopedAllocator<char>>::basic_string; // "inherit" the constructors.
+        VariantString() = default;
+        VariantString(const std::string& value) : VariantString(value.data(), value.size()) {}
+        explicit VariantString(std::string_view value) : VariantString(value.data(), value.size()) {}
+        using std::basic_string<char, std::char_traits<char>, ScopedAllocator<char>>::operator=;
+
+        operator std::string() const { return std::string(data(), size()); }
+
+        friend bool operator==(const VariantString& left, const VariantString& right) { return std::string_view(left) == std::string_view(right); }
+        friend bool operator==(const VariantString& left, const std::string& right) { return std::string_view(left) == std::string_view(right); }
+        friend bool operator==(const VariantString& left, std::string_view right) { return std::string_view(left) == right; }
+        friend bool operator==(const VariantString& left, const char* right) { return std::string_view(left) == right; }
+    };
+
+    // key of a VariantMap, an immutable reference counted string so copies are cheap, keys of the same name parsed
+    // from one document or interned by one KeyTable share the string and compare equal by the pointer alone
+    class Key
+    {
+    public:
+        Key() noexcept : pData_(nullptr) {}
+        Key(const char* name);
+        Key(const std::string& name);
+        Key(std::string&& name);
+        explicit Key(std::string_view name);
+        Key(const Key& key) noexcept : pData_(key.pData_) { acquire(); }
+        Key(Key&& key) noexcept : pData_(key.pData_) { key.pData_ = nullptr; }
+        ~Key() { release(); }
+
+        Key& operator=(const Key& key) noexcept
+        {
+            Key copy(key);
+            std::swap(pData_, copy.pData_);
+            return *this;
+        }
+
+        Key& operator=(Key&& key) noexcept
+        {
+            std::swap(pData_, key.pData_);
+            return *this;
+        }
+
+        const VariantString& str() const
+        {
+            static const VariantString empty{ ScopedAllocator<char>(nullptr) };
+            return pData_ ? pData_->value : empty;
+        }
+
+        operator const VariantString&() const { return str(); }
+        operator std::string_view() const { return str(); }
+        const char* c_str() const { return str().c_str(); }
+        size_t size() const { return str().size(); }
+        bool empty() const { return str().empty(); }
+
+        bool operator==(const Key& key) const
+        {
+            return pData_ == key.pData_ || str() == key.str();
+        }
+
+        std::strong_ordering operator<=>(const Key& key) const
+        {
+            if (pData_ == key.pData_)
+                return std::strong_ordering::equal;
+
+            return std::string_view(str()) <=> std::string_view(key.str());
+        }
+
+        template <typename T> requires (!std::is_same_v<T, Key> && std::is_convertible_v<const T&, std::string_view>)
+        bool operator==(const T& name) const
+        {
+            return std::string_view(str()) == std::string_view(name);
+        }
+
+        template <typename T> requires (!std::is_same_v<T, Key> && std::is_convertible_v<const T&, std::string_view>)
+        std::strong_ordering operator<=>(const T& name) const
+        {
+            return std::string_view(str()) <=> std::string_view(name);
+        }
+
+    private:
+        friend class KeyTable;
+        // allocated like the value blocks, keys interned by a KeyTable come from the global heap
+        struct Data
+        {
+            explicit Data(std::string_view name) : value(name) {}
+
+            std::atomic<uint32_t> refCount{ 1 };
+            std::pmr::memory_resource* pResource = MemoryScope::current();
+            VariantString value;
+
+            static void* operator new(size_t size)
+            {
+                std::pmr::memory_resource* pResource = MemoryScope::current();
+                return pResource ? pResource->allocate(size, alignof(Data)) : ::operator new(size);
+            }
+
+            static void operator delete(void* p)
+            {
+                std::pmr::memory_resource* pResource = MemoryScope::current();
+                if (pResource)
+                    pResource->deallocate(p, sizeof(Data), alignof(Data));
+                else
+                    ::operator delete(p);
+            }
+
+            static void operator delete(Data* p, std::destroying_delete_t)
+            {
+                std::pmr::memory_resource* pResource = p->pResource;
+                p->~Data();
+                if (pResource)
+                    pResource->deallocate(p, sizeof(Data), alignof(Data));
+                else
+                    ::operator delete(p);
+            }
+        };
+
+        void acquire() noexcept
+        {
+            if (pData_)
+                pData_->refCount.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        void release() noexcept
+        {
+            if (pData_ && pData_->refCount.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                delete pData_;
+        }
+
+        Data* pData_;
+    };
+
+    // thread safe table of interned keys shared by parsers of many documents, see ParseOptions
+    class KeyTable
+    {
+    public:
+        KeyTable();
+        ~KeyTable();
+        KeyTable(const KeyTable&) = delete;
+        KeyTable& operator=(const KeyTable&) = delete;
+
+        Key intern(std::string_view name);
+        size_t size() const;
+        void clear();   // keys handed out before stay valid
+
+    private:
+        struct Impl;
+        std::unique_ptr<Impl> pImpl_;
+    };
+
+    struct ParseOptions
+    {
+        KeyTable* pKeyTable = nullptr;  // keys are shared within one document always, with a table across documents too
+        bool typedArrays = false;       // arrays of numbers only are stored contiguously as Type::NumberArray
+        bool shareShapes = false;       // objects are stored as Type::Record, objects with equal keys share one Shape
+        size_t maxDepth = 512;          // deepest nesting of containers accepted, the parser does not recurse either way
+        size_t maxDocumentSize = (size_t)-1;    // longest input in bytes accepted, checked before parsing starts
+        std::pmr::memory_resource* pMemoryResource = nullptr;   // of all parsed memory, the current MemoryScope if null
+    };
+
+    // sorted keys of a Type::Record, shared by all records of the same key set parsed from one document or one Parser
+    class Shape
+    {
+    public:
+        static constexpr size_t npos = (size_t)-1;
+
+        // keys in any order, they are sorted and Variant::record takes the values in the order given here, throws
+        // std::runtime_error for duplicated keys
+        explicit Shape(std::vector<Key>&& keys);
+        size_t size() const;
+        const Key& key(size_t index) const;
+        size_t indexOf(std::string_view name) const;
+
+    private:
+        friend class Variant;
+
+        std::vector<Key> keys_;
+        std::vector<size_t> sortedIndices_;     // of the keys in the order given, empty if they came sorted
     };
 
     class Variant;
-    template <typename T1, typename T2> struct _VariantMap : std::map<T1, T2>
+    class CompiledSchema;
+
+    // finds a key in maps and records, the index of the key is remembered for the last shape seen, so repeated
+    // lookups in records of one shape are a plain indexed load, an accessor must not be shared by threads
+    class FieldAccessor
     {
-        using std::map<T1, T2>::map; // "inherit" the constructors.
+    public:
+        explicit FieldAccessor(std::string_view key);
+        const Variant* find(const Variant& object);
+        const Variant& operator()(const Variant& object);
+
+    private:
+        std::string key_;
+        std::shared_ptr<const Shape> pShape_;
+        size_t index_ = Shape::npos;
+    };
+    template <typename T1, typename T2> struct _VariantMap : std::map<T1, T2, std::less<>, ScopedAllocator<std::pair<const T1, T2>>>
+    {
+        using std::map<T1, T2, std::less<>, ScopedAllocator<std::pair<const T1, T2>>>::map; // "inherit" the constructors.
         bool contains(const char* key) const
         {
             return (this->find(key) != this->end());
@@ -52,48 +500,133 @@ namespace JsonSerialization
 
         const Variant& operator()(const char* key) const
         {
-            return this->at(key);
+            const auto it = this->find(key);
+            if (it == this->end())
+                throw std::out_of_range("Missing key in map");
+
+            return it->second;
         }
     };
 
-    typedef _VariantMap<std::string, Variant> VariantMap;
-    typedef std::vector<Variant> VariantVector;
+    typedef _VariantMap<Key, Variant> VariantMap;
+    typedef std::vector<Variant, ScopedAllocator<Variant>> VariantVector;
     class Variant
     {
     private:
+        // strings and containers live in reference counted blocks, with copy on write enabled copies share them
+        struct SharedBlock
+        {
+            std::atomic<uint32_t> refCount{ 1 };
+            Type type = Type::Empty;            // only needed by the boxed layout, they fit the padding anyway
+            NumberType numberType = NumberType::Double;
+            std::pmr::memory_resource* pResource = MemoryScope::current();     // the block was allocated from
+        };
+
+        template <typename T> struct SharedData : SharedBlock
+        {
+            T value;
+
+            template <typename... Args> explicit SharedData(Args&&... args)
+                : value(std::forward<Args>(args)...)
+            {
+#ifdef JSON_VARIANT_STATS
+                if (JsonSerializationInternal::collectingOperations)
+                    JsonSerializationInternal::countAllocation(sizeof(*this));
+#endif
+            }
+
+            static void* operator new(size_t size)
+            {
+                std::pmr::memory_resource* pResource = MemoryScope::current();
+                return pResource ? pResource->allocate(size, alignof(SharedData)) : ::operator new(size);
+            }
+
+            // only when the constructor throws, the scope of the allocation is still the current one then
+            static void operator delete(void* p)
+            {
+                std::pmr::memory_resource* pResource = MemoryScope::current();
+                if (pResource)
+                    pResource->deallocate(p, sizeof(SharedData), alignof(SharedData));
+                else
+                    ::operator delete(p);
+            }
+
+            static void operator delete(SharedData* p, std::destroying_delete_t)
+            {
+                std::pmr::memory_resource* pResource = p->pResource;
+                p->~SharedData();
+                if (pResource)
+                    pResource->deallocate(p, sizeof(SharedData), alignof(SharedData));
+                else
+                    ::operator delete(p);
+            }
+        };
+
+#ifdef JSON_VARIANT_NAN_BOXING
+        // one 64-bit word, doubles are stored as they are, everything else goes to the payload of negative quiet NaNs
+        // with a tag in bits 48-50, integers up to 48 bits are inline and the bigger ones are boxed in a block
+        enum class Tag : uint64_t
+        {
+            Empty,
+            Null,
+            Bool,
+            Int,
+            String,
+            Vector,
+            Map,
+            Block       // number array or boxed integer, the block tells which
+        };
+
+        static constexpr uint64_t boxedMask = 0xFFF8000000000000ULL;
+        static constexpr uint64_t payloadMask = 0x0000FFFFFFFFFFFFULL;
+        static constexpr uint64_t canonicalNaN = 0x7FF8000000000000ULL;
+
+        uint64_t bits_;
+#else
         union PDATA
         {
             bool boolValue;
             double numberValue;
+            int64_t intValue;
+            uint64_t uintValue;
             void* pData;
         };
 
         PDATA pData_;
         Type type_;
+        NumberType numberType_ = NumberType::Double;
+#endif
 
     public:
         Variant();
         Variant(std::nullptr_t);
         Variant(int value);
+        Variant(unsigned int value);
+        Variant(long value);
+        Variant(unsigned long value);
+        Variant(long long value);
+        Variant(unsigned long long value);
         Variant(double value);
         Variant(bool value);
         Variant(const char* value);
         Variant(const std::string& value);
-        Variant(std::string&& value) noexcept;
+        Variant(std::string&& value);
+        Variant(const VariantString& value);
+        Variant(VariantString&& value);
         Variant(const VariantVector& value);
-        Variant(VariantVector&& value) noexcept;
+        Variant(VariantVector&& value);
         Variant(const VariantMap& value);
-        Variant(VariantMap&& value) noexcept;
+        Variant(VariantMap&& value);
         Variant(const Variant& value);
         Variant(Variant&& value) noexcept;
         template <typename T> Variant(const std::vector<T> &value)
         {
-            JsonSerialization::VariantVector *pVector = new JsonSerialization::VariantVector;
+            JsonSerialization::VariantVector variantVector;
+            variantVector.reserve(value.size());
             for (const auto &v : value)
-                pVector->push_back(v);
+                variantVector.push_back(v);
 
-            type_ = JsonSerialization::Type::Vector;
-            pData_.pData = pVector;
+            create<VariantVector>(JsonSerialization::Type::Vector, std::move(variantVector));
         }
 
         ~Variant();
@@ -105,52 +638,624 @@ namespace JsonSerialization
         Type type() const;
         bool isEmpty() const;
         bool isNull() const;
+        NumberType numberType() const;
+        bool isInteger() const;
         int toInt() const;
+        int64_t toInt64() const;
+        uint64_t toUInt64() const;
         double toNumber() const;
+        double toDouble() const;
         bool toBool() const;
-        const std::string& toString() const;
+        const VariantString& toString() const;
         const VariantVector& toVector() const;
         const VariantMap& toMap() const;
 
-        template<typename T> T value() const
+        // elements of a Type::NumberArray, its numberType() tells which of them holds the data
+        std::span<const double> toDoubleArray() const;
+        std::span<const int64_t> toInt64Array() const;
+        static Variant numberArray(std::vector<double>&& values);
+        static Variant numberArray(std::vector<int64_t>&& values);
+
+        // values of a Type::Record in the order of its shape keys, record takes them in the order the keys were given
+        // to the Shape
+        const Shape& shape() const;
+        std::span<const Variant> recordValues() const;
+        static Variant record(std::shared_ptr<const Shape> pShape, VariantVector&& values);
+
+        // value of a key in a map or a record, nullptr when the key or the object is missing
+        const Variant* find(std::string_view key) const;
+
+        // detach the data first when it is shared with copies, the references stay valid until the variant changes
+        VariantString& toMutableString();
+        VariantVector& toMutableVector();
+        VariantMap& toMutableMap();
+
+        // move the data out, the variant is empty afterwards
+        VariantString takeString() &&;
+        VariantVector takeVector() &&;
+        VariantMap takeMap() &&;
+
+        template<typename T> T value() const &
         {
             T val;
             _value(val);
             return val;
         }
 
-        template<typename T> void value(T& val) const
+        template<typename T> T value() &&
+        {
+            T val;
+            std::move(*this).value(val);
+            return val;
+        }
+
+        template<typename T> void value(T& val) const &
         {
             _value(val);
         }
 
-        template<typename T> void valueVector(std::vector<T> &value) const
+        template<typename T> void value(T& val) &&
+        {
+            if constexpr (std::is_same_v<T, std::string>)
+                val = std::move(*this).takeString();
+            else
+                _value(val);
+        }
+
+        template<typename T> void valueVector(std::vector<T> &value) const &
         {
+            if (kind() == Type::NumberArray)
+            {
+                if constexpr (std::is_arithmetic_v<T> && !std::is_same_v<T, bool>)
+                    return visitNumberArray([&value](auto numbers) { value.assign(numbers.begin(), numbers.end()); });
+                else
+                    throw std::runtime_error("Not vector in variant");
+            }
+
             const VariantVector &variantVector = toVector();
             value.clear();
+            value.reserve(variantVector.size());
             for (const auto &v : variantVector)
-            {
-                T t;
-                v.value(t);
-                value.push_back(t);
-            }
+                value.push_back(v.template value<T>());
+        }
+
+        template<typename T> void valueVector(std::vector<T> &value) &&
+        {
+            if (kind() == Type::NumberArray)
+                return valueVector(value);
+
+            VariantVector variantVector = std::move(*this).takeVector();
+            value.clear();
+            value.reserve(variantVector.size());
+            for (auto &v : variantVector)
+                value.push_back(std::move(v).template value<T>());
         }
 
         std::string toJson(bool pretty = false) const;
+
+        // copies of strings, vectors and maps share the data until one of them is modified, off by default
+        static void setCopyOnWrite(bool enabled);
+        static bool copyOnWrite();
+
+        // hands the content over to a background thread which frees it, the variant is empty afterwards
+        void releaseAsync();
+
         static bool fromJson(const std::string& jsonStr, Variant& jsonVariant, std::string* errorStr = nullptr);
+        static ParseResult parse(std::string_view jsonStr, Variant& jsonVariant, const ParseOptions& options = ParseOptions()) noexcept;
+
+        // the file is parsed straight from a read only memory mapping, without reading it into a string first
+        static bool fromJsonFile(const std::string& path, Variant& jsonVariant, std::string* errorStr = nullptr);
+        static bool fromJsonFile(const std::string& path, Variant& jsonVariant, const ParseOptions& options, std::string* errorStr = nullptr);
+        static ParseResult parseFile(const std::string& path, Variant& jsonVariant, const ParseOptions& options = ParseOptions()) noexcept;
+        static bool fromJson(const std::string& jsonStr, Variant& jsonVariant, const ParseOptions& options, std::string* errorStr = nullptr);
         static bool fromJson(const std::string& jsonStr, const std::string& jsonSchema, Variant& jsonVariant, std::string* errorStr = nullptr);
+        static bool fromJson(const std::string& jsonStr, const CompiledSchema& jsonSchema, Variant& jsonVariant, std::string* errorStr = nullptr);
+        static bool validate(const Variant& schemaVariant, const Variant& jsonVariant, ValidationResult& result);
         
     private:
+#ifdef JSON_VARIANT_NAN_BOXING
+        static constexpr uint64_t boxed(Tag tag, uint64_t payload)
+        {
+            return boxedMask | ((uint64_t)tag << 48) | (payload & payloadMask);
+        }
+
+        bool isBoxed() const { return (bits_ & boxedMask) == boxedMask; }
+        Tag tag() const { return (Tag)((bits_ >> 48) & 7); }
+        uint64_t payload() const { return bits_ & payloadMask; }
+
+        Type kind() const
+        {
+            if (!isBoxed())
+                return Type::Number;
+
+            switch (tag())
+            {
+            case Tag::Empty: return Type::Empty;
+            case Tag::Null: return Type::Null;
+            case Tag::Bool: return Type::Bool;
+            case Tag::Int: return Type::Number;
+            case Tag::String: return Type::String;
+            case Tag::Vector: return Type::Vector;
+            case Tag::Map: return Type::Map;
+            default: return block()->type;
+            }
+        }
+
+        NumberType numberKind() const
+        {
+            if (!isBoxed())
+                return NumberType::Double;
+
+            return (tag() == Tag::Int) ? NumberType::Int64 : block()->numberType;
+        }
+
+        bool hasBlock() const { return isBoxed() && tag() >= Tag::String; }
+        SharedBlock* block() const { return reinterpret_cast<SharedBlock*>((uintptr_t)payload()); }
+
+        void setBlock(SharedBlock* pBlock, Type type, NumberType numberType)
+        {
+            Tag tag = Tag::Block;
+            if (type == Type::String)
+                tag = Tag::String;
+            else if (type == Type::Vector)
+                tag = Tag::Vector;
+            else if (type == Type::Map)
+                tag = Tag::Map;
+
+            pBlock->type = type;
+            pBlock->numberType = numberType;
+            bits_ = boxed(tag, (uint64_t)reinterpret_cast<uintptr_t>(pBlock));
+        }
+
+        void setEmpty() { bits_ = boxed(Tag::Empty, 0); }
+        void setNull() { bits_ = boxed(Tag::Null, 0); }
+        bool boolValue() const { return payload() != 0; }
+        void setBool(bool value) { bits_ = boxed(Tag::Bool, value ? 1 : 0); }
+        double doubleValue() const { return std::bit_cast<double>(bits_); }
+        void setDouble(double value) { bits_ = (value != value) ? canonicalNaN : std::bit_cast<uint64_t>(value); }
+
+        int64_t int64Value() const
+        {
+            if (tag() == Tag::Int)
+                return (int64_t)(bits_ << 16) >> 16;
+
+            return data<int64_t>();
+        }
+
+        void setInt64(int64_t value)
+        {
+            if (value == ((int64_t)((uint64_t)value << 16) >> 16))
+                bits_ = boxed(Tag::Int, (uint64_t)value);
+            else
+                setBlock(new SharedData<int64_t>(value), Type::Number, NumberType::Int64);
+        }
+
+        uint64_t uint64Value() const { return data<uint64_t>(); }
+        void setUInt64(uint64_t value) { setBlock(new SharedData<uint64_t>(value), Type::Number, NumberType::UInt64); }
+        void copyStorage(const Variant& value) { bits_ = value.bits_; }
+#else
+        Type kind() const { return type_; }
+        NumberType numberKind() const { return numberType_; }
+        bool hasBlock() const { return type_ >= Type::String; }
+        SharedBlock* block() const { return static_cast<SharedBlock*>(pData_.pData); }
+
+        void setBlock(SharedBlock* pBlock, Type type, NumberType numberType)
+        {
+            type_ = type;
+            numberType_ = numberType;
+            pData_.pData = pBlock;
+        }
+
+        void setEmpty() { type_ = Type::Empty; pData_.pData = nullptr; }
+        void setNull() { type_ = Type::Null; pData_.pData = nullptr; }
+        bool boolValue() const { return pData_.boolValue; }
+        void setBool(bool value) { type_ = Type::Bool; pData_.uintValue = 0; pData_.boolValue = value; }
+        double doubleValue() const { return pData_.numberValue; }
+        void setDouble(double value) { type_ = Type::Number; numberType_ = NumberType::Double; pData_.numberValue = value; }
+        int64_t int64Value() const { return pData_.intValue; }
+        void setInt64(int64_t value) { type_ = Type::Number; numberType_ = NumberType::Int64; pData_.intValue = value; }
+        uint64_t uint64Value() const { return pData_.uintValue; }
+        void setUInt64(uint64_t value) { type_ = Type::Number; numberType_ = NumberType::UInt64; pData_.uintValue = value; }
+
+        void copyStorage(const Variant& value)
+        {
+            pData_ = value.pData_;
+            type_ = value.type_;
+            numberType_ = value.numberType_;
+        }
+#endif
+
+        template <typename T, typename... Args> void create(Type type, Args&&... args)
+        {
+            setBlock(new SharedData<T>(std::forward<Args>(args)...), type, NumberType::Double);
+        }
+
+        template <typename T> T& data() const
+        {
+            return static_cast<SharedData<T>*>(block())->value;
+        }
+
+        template <typename F> decltype(auto) visitNumberArray(F&& f) const
+        {
+            if (numberKind() == NumberType::Double)
+                return f(std::span<const double>(data<NumberVector<double>>()));
+
+            return f(std::span<const int64_t>(data<NumberVector<int64_t>>()));
+        }
+
+        template <typename T> using NumberVector = std::vector<T, ScopedAllocator<T>>;     // of a Type::NumberArray
+
+        struct RecordData
+        {
+            std::shared_ptr<const Shape> pShape;
+            VariantVector values;
+        };
+
+        friend class FieldAccessor;
+        template <typename T> T takeData();
+        template <typename T> void detachData();
+        void detach();
+        void releaseShallow(std::vector<Variant>& pending);
         void clear();
         void copyAll(const Variant& value);
         void moveAll(Variant &&value) noexcept;
         std::string _toJson() const;
         std::string _toJson(int& intend) const;
+        std::string numberToJson() const;
         void _value(int& val) const;
+        void _value(unsigned int& val) const;
+        void _value(long& val) const;
+        void _value(unsigned long& val) const;
+        void _value(long long& val) const;
+        void _value(unsigned long long& val) const;
         void _value(double& val) const;
+        void _value(float& val) const;
         void _value(bool& val) const;
         void _value(std::string& val) const;
     };
+
+    // accessors inline in either build, extraction loops over a VariantMap do not pay a call per field
+    inline Variant::Variant()
+    {
+        setEmpty();
+    }
+
+    inline Variant::Variant(std::nullptr_t)
+    {
+        setNull();
+    }
+
+    inline Variant::Variant(Variant&& value) noexcept
+    {
+        moveAll(std::move(value));
+    }
+
+    inline Variant& Variant::operator=(Variant&& value) noexcept
+    {
+        if (this != &value)
+        {
+            if (hasBlock())
+                clear();
+
+            moveAll(std::move(value));
+        }
+
+        return *this;
+    }
+
+    inline Variant::~Variant()
+    {
+        if (hasBlock())
+            clear();
+    }
+
+    inline Type Variant::type() const
+    {
+        return kind();
+    }
+
+    inline bool Variant::isEmpty() const
+    {
+        return (kind() == Type::Empty);
+    }
+
+    inline bool Variant::isNull() const
+    {
+        return (kind() == Type::Null);
+    }
+
+    inline NumberType Variant::numberType() const
+    {
+        if (kind() == Type::Number || kind() == Type::NumberArray)
+            return numberKind();
+
+        throw std::runtime_error("Not number in variant");
+    }
+
+    inline bool Variant::isInteger() const
+    {
+        if (kind() != Type::Number)
+            return false;
+
+        if (numberKind() != NumberType::Double)
+            return true;
+
+        return std::isfinite(doubleValue()) && std::trunc(doubleValue()) == doubleValue();
+    }
+
+    inline int Variant::toInt() const
+    {
+        int64_t value = toInt64();
+        if (value < std::numeric_limits<int>::min() || value > std::numeric_limits<int>::max())
+            throw std::runtime_error("Number out of range in variant");
+
+        return (int)value;
+    }
+
+    inline int64_t Variant::toInt64() const
+    {
+        if (kind() == Type::Number)
+        {
+            switch (numberKind())
+            {
+            case NumberType::Int64:
+                return int64Value();
+
+            case NumberType::UInt64:
+                throw std::runtime_error("Number out of range in variant");
+
+            default:
+                // the conversion truncates, NaN and doubles outside of the range fail both comparisons
+                if (!(doubleValue() >= -9223372036854775808.0 && doubleValue() < 9223372036854775808.0))
+                    throw std::runtime_error("Number out of range in variant");
+
+                return (int64_t)doubleValue();
+            }
+        }
+
+        throw std::runtime_error("Not integer in variant");
+    }
+
+    inline uint64_t Variant::toUInt64() const
+    {
+        if (kind() == Type::Number)
+        {
+            switch (numberKind())
+            {
+            case NumberType::Int64:
+                if (int64Value() < 0)
+                    throw std::runtime_error("Number out of range in variant");
+
+                return (uint64_t)int64Value();
+
+            case NumberType::UInt64:
+                return uint64Value();
+
+            default:
+                if (!(doubleValue() > -1.0 && doubleValue() < 18446744073709551616.0))
+                    throw std::runtime_error("Number out of range in variant");
+
+                return (uint64_t)doubleValue();
+            }
+        }
+
+        throw std::runtime_error("Not integer in variant");
+    }
+
+    inline double Variant::toNumber() const
+    {
+        if (kind() == Type::Number)
+        {
+            switch (numberKind())
+            {
+            case NumberType::Int64:
+                return (double)int64Value();
+
+            case NumberType::UInt64:
+                return (double)uint64Value();
+
+            default:
+                return doubleValue();
+            }
+        }
+
+        throw std::runtime_error("Not number in variant");
+    }
+
+    inline double Variant::toDouble() const
+    {
+        return toNumber();
+    }
+
+    inline bool Variant::toBool() const
+    {
+        if (kind() == Type::Bool)
+            return boolValue();
+
+        throw std::runtime_error("Not bool in variant");
+    }
+
+    inline const VariantString& Variant::toString() const
+    {
+        if (kind() == Type::String)
+            return data<VariantString>();
+
+        throw std::runtime_error("Not string in variant");
+    }
+
+    inline const VariantVector& Variant::toVector() const
+    {
+        if (kind() == Type::Vector)
+            return data<VariantVector>();
+
+        throw std::runtime_error("Not vector in variant");
+    }
+
+    inline const VariantMap& Variant::toMap() const
+    {
+        if (kind() == Type::Map)
+            return data<VariantMap>();
+
+        throw std::runtime_error("Not map in variant");
+    }
+
+    inline const Variant* Variant::find(std::string_view key) const
+    {
+        if (kind() == Type::Map)
+        {
+            const VariantMap& variantMap = data<VariantMap>();
+            auto it = variantMap.find(key);
+            return it == variantMap.end() ? nullptr : &it->second;
+        }
+
+        if (kind() == Type::Record)
+        {
+            const RecordData& record = data<RecordData>();
+            size_t index = record.pShape->indexOf(key);
+            return index == Shape::npos ? nullptr : &record.values[index];
+        }
+
+        return nullptr;
+    }
+
+    inline void Variant::moveAll(Variant&& value) noexcept
+    {
+        copyStorage(value);
+        value.setEmpty();
+    }
+
+    // schema parsed and prepared once, validating with it skips parsing, hashing and looking up the schema text, it is
+    // immutable and can be shared by threads, see JsonLiteral for schemas checked at compile time
+    class CompiledSchema
+    {
+    public:
+        explicit CompiledSchema(std::string_view schemaText);     // throws std::runtime_error for malformed json
+        explicit CompiledSchema(const Variant& schemaVariant);
+
+        const Variant& schema() const;
+        bool validate(const Variant& jsonVariant, ValidationResult& result) const;
+
+    private:
+        std::shared_ptr<const JsonSerializationInternal::PreparedSchema> pPreparedSchema_;
+    };
+
+    // keeps its buffers, key and shape caches and scratch stacks from one document to the next, so a thread parsing
+    // document after document allocates little beyond the resulting trees, an instance must not be shared by threads
+    class Parser
+    {
+    public:
+        explicit Parser(const ParseOptions& options = ParseOptions());
+        ~Parser();
+        Parser(const Parser&) = delete;
+        Parser& operator=(const Parser&) = delete;
+
+        ParseResult parse(std::string_view jsonStr, Variant& jsonVariant) noexcept;
+        ParseResult parseFile(const std::string& path, Variant& jsonVariant) noexcept;
+        void clear();   // forgets the cached keys and shapes and frees the buffers
+
+    private:
+        struct Impl;
+        std::unique_ptr<Impl> pImpl_;
+    };
+
+    // resumes a coroutine once a file descriptor becomes readable, parseAsync waits through it whenever a read
+    // would block, false is returned when the descriptor can not be waited for
+    class IoScheduler
+    {
+    public:
+        virtual ~IoScheduler() = default;
+        virtual bool waitReadable(int fd, std::coroutine_handle<> handle) = 0;
+
+        // the coroutine waiting on the descriptor is destroyed before it was resumed, it must not be resumed anymore
+        virtual void cancel(int fd) = 0;
+    };
+
+#ifdef __linux__
+    // single threaded scheduler, run() waits for the registered descriptors and resumes the coroutines of the ready ones
+    class EpollScheduler : public IoScheduler
+    {
+    public:
+        EpollScheduler();
+        ~EpollScheduler() override;
+        EpollScheduler(const EpollScheduler&) = delete;
+        EpollScheduler& operator=(const EpollScheduler&) = delete;
+
+        bool waitReadable(int fd, std::coroutine_handle<> handle) override;
+        void cancel(int fd) override;
+        size_t run(int timeoutMs = -1);     // number of resumed coroutines
+        size_t pending() const;
+
+    private:
+        int epollFd_;
+        std::map<int, std::coroutine_handle<>> waiting_;    // by descriptor, a cancelled one is skipped by run()
+    };
+#endif
+
+    // result of parseAsync, it can be polled with done() or awaited from another coroutine
+    class ParseTask
+    {
+    public:
+        struct promise_type
+        {
+            struct FinalAwaiter
+            {
+                bool await_ready() noexcept { return false; }
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> handle) noexcept
+                {
+                    std::coroutine_handle<> continuation = handle.promise().continuation;
+                    return continuation ? continuation : std::noop_coroutine();
+                }
+                void await_resume() noexcept {}
+            };
+
+            ParseTask get_return_object() { return ParseTask(std::coroutine_handle<promise_type>::from_promise(*this)); }
+            std::suspend_never initial_suspend() noexcept { return {}; }
+            FinalAwaiter final_suspend() noexcept { return {}; }
+            void return_value(const ParseResult& value) { result = value; }
+            void unhandled_exception() { result = ParseResult(); result.code = ParseErrorCode::OutOfMemory; }
+
+            ParseResult result;
+            std::coroutine_handle<> continuation;
+        };
+
+        ParseTask(ParseTask&& task) noexcept : handle_(std::exchange(task.handle_, nullptr)) {}
+        ParseTask& operator=(ParseTask&& task) noexcept
+        {
+            if (handle_)
+                handle_.destroy();
+
+            handle_ = std::exchange(task.handle_, nullptr);
+            return *this;
+        }
+        ~ParseTask()
+        {
+            if (handle_)
+                handle_.destroy();
+        }
+
+        bool done() const { return handle_.done(); }
+        const ParseResult& result() const { return handle_.promise().result; }
+
+        bool await_ready() const { return handle_.done(); }
+        void await_suspend(std::coroutine_handle<> handle) { handle_.promise().continuation = handle; }
+        ParseResult await_resume() const { return handle_.promise().result; }
+
+    private:
+        explicit ParseTask(std::coroutine_handle<promise_type> handle) : handle_(handle) {}
+
+        std::coroutine_handle<promise_type> handle_;
+    };
+
+    // reads one document from a non blocking descriptor until it is complete or the descriptor ends, it suspends
+    // whenever a read would block, the variant has to outlive the task and bytes following the document are dropped
+#ifndef _WIN32
+    ParseTask parseAsync(int fd, Variant& jsonVariant, IoScheduler& scheduler, ParseOptions options = ParseOptions());
+#endif
 }
 
+// jsonVariant.hpp sets it, so does the jsonVariant::jsonVariantHeaderOnly cmake target
+#ifdef JSON_VARIANT_HEADER_ONLY
+#include "jsonVariantImpl.h"
+#endif
+
 #endif
@@ -0,0 +1,12 @@
+#ifndef __JSON_VARIANT_HPP
+#define __JSON_VARIANT_HPP
+
+// header only form of the library, nothing to build or link, every translation unit of a program has to include
+// this header then and the compiled library must not be linked along
+#ifndef JSON_VARIANT_HEADER_ONLY
+#define JSON_VARIANT_HEADER_ONLY
+#endif
+
+#include "jsonVariant.h"
+
+#endif
@@ -0,0 +1,4345 @@
+#ifndef __JSON_VARIANT_IMPL_H
+#define __JSON_VARIANT_IMPL_H
+
+// definitions of the library, compiled once by src/jsonVariant.cpp or included by every user of jsonVariant.hpp
+#include "jsonVariant.h"
+#include <regex>
+#include <stdexcept>
+#include <cstdint>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <ostream>
+#include <charconv>
+#include <set>
+#include <system_error>
+#include <string_view>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+
+#ifdef _WIN32
+    #include <fstream>
+    #include <iterator>
+#else
+    #include <cerrno>
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+#ifdef __linux__
+    #include <sys/epoll.h>
+#endif
+
+#ifdef JSON_VARIANT_HEADER_ONLY
+    #define JSON_VARIANT_INLINE inline
+#else
+    #define JSON_VARIANT_INLINE
+#endif
+
+namespace JsonSerializationInternal
+{
+    using namespace JsonSerialization;
+
+    // platform specific newline string
+#ifdef _WIN32
+    JSON_VARIANT_INLINE const std::string endLineStr = "\r\n";
+#else
+    JSON_VARIANT_INLINE const std::string endLineStr = "\n";
+#endif
+
+    inline bool isIgnorable(char d) {
+        return d == ' ' || d == '\n' || d == '\t' || d == '\r';
+    }
+
+    inline bool isInteger(double d)
+    {
+        return std::isfinite(d) && std::trunc(d) == d;
+    }
+
+    // set for pool workers and for the caller while it takes part in a parallel job, nested jobs run serially
+    JSON_VARIANT_INLINE thread_local bool insideParallelJob = false;
+
+    JSON_VARIANT_INLINE std::atomic<bool> copyOnWriteEnabled{ false };
+
+    // the callback is swapped under the mutex and called through a copy of the pointer, so it may be replaced
+    // while operations of other threads still report to the previous one
+    JSON_VARIANT_INLINE std::atomic<bool> instrumentationEnabled{ false };
+    JSON_VARIANT_INLINE std::mutex instrumentationMutex;
+    JSON_VARIANT_INLINE std::shared_ptr<const Instrumentation::Callback> pInstrumentationCallback;
+    JSON_VARIANT_INLINE thread_local OperationStats lastOperationStats;
+    JSON_VARIANT_INLINE thread_local std::pmr::memory_resource* pCurrentMemoryResource = nullptr;
+#ifdef JSON_VARIANT_STATS
+    JSON_VARIANT_INLINE thread_local size_t collectingOperations = 0;
+    JSON_VARIANT_INLINE thread_local size_t allocationCount = 0;
+    JSON_VARIANT_INLINE thread_local size_t allocationBytes = 0;
+#endif
+
+    class WorkerPool
+    {
+    public:
+        static WorkerPool& instance();
+        size_t size() const;
+        void run(std::function<void()> body, size_t helpers);
+        ~WorkerPool();
+
+    private:
+        struct Job
+        {
+            std::function<void()> body;
+            std::mutex mutex;
+            std::condition_variable finished;
+            size_t active = 0;
+            bool closed = false;
+            std::exception_ptr error;   // first one thrown by the body, rethrown on the caller
+        };
+
+        WorkerPool();
+        void workerLoop();
+        static void execute(Job& job) noexcept;
+
+        std::vector<std::thread> workers_;
+        std::deque<std::shared_ptr<Job>> queue_;
+        std::mutex mutex_;
+        std::condition_variable wakeUp_;
+        bool stopping_ = false;
+    };
+
+    // read only view of a whole file, it is mapped into memory where the platform allows it and read elsewhere
+    class MappedFile
+    {
+    public:
+        explicit MappedFile(const std::string& path);
+        ~MappedFile();
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        bool isOpen() const;
+        std::string_view view() const;
+
+    private:
+        bool isOpen_ = false;
+        const char* pData_ = nullptr;
+        size_t size_ = 0;
+#ifdef _WIN32
+        std::string content_;
+#endif
+    };
+
+    // finds the end of a document arriving in chunks by following strings and the nesting of containers, anything
+    // else than an object or an array ends the document at once and is left to the parser to report
+    class DocumentScanner
+    {
+    public:
+        bool feed(std::string_view chunk);  // true once the document is complete
+        size_t size() const;                // length of the document up to its end
+
+    private:
+        size_t size_ = 0;
+        size_t depth_ = 0;
+        bool started_ = false;
+        bool inString_ = false;
+        bool escaped_ = false;
+    };
+
+    // measures one operation for the Instrumentation callback, without JSON_VARIANT_STATS it does nothing at all
+    class OperationScope
+    {
+    public:
+#ifdef JSON_VARIANT_STATS
+        explicit OperationScope(Operation operation);
+        ~OperationScope();
+        OperationScope(const OperationScope&) = delete;
+        OperationScope& operator=(const OperationScope&) = delete;
+        void finish(bool succeeded, size_t bytes, const Variant* pDocument);
+
+    private:
+        static void collectNodes(const Variant& document, OperationStats& stats);
+
+        bool enabled_;
+        OperationStats stats_;
+        std::chrono::steady_clock::time_point start_;
+#else
+        explicit OperationScope(Operation) {}
+        void finish(bool, size_t, const Variant*) {}
+#endif
+    };
+
+    // single background thread which frees documents handed over by Variant::releaseAsync, the instance is never
+    // destroyed and its thread is joined at exit, documents released after that are freed by the calling thread
+    class BackgroundReleaser
+    {
+    public:
+        static BackgroundReleaser& instance();
+        bool release(Variant&& variant);
+
+    private:
+        BackgroundReleaser() = default;
+        void stop();
+        void releaseLoop();
+
+        std::thread thread_;
+        std::vector<Variant> queue_;
+        std::mutex mutex_;
+        std::condition_variable wakeUp_;
+        bool stopping_ = false;
+    };
+
+    // keys seen while parsing one document, names missing here are taken from the shared table if there is one,
+    // the others are allocated from the resource given since they outlive the documents they were parsed from
+    class KeyCache
+    {
+    public:
+        KeyCache(KeyTable* pKeyTable, std::pmr::memory_resource* pResource);
+        const Key& get(std::string_view name);
+        size_t size() const;
+        void clear();
+
+    private:
+        KeyTable* pKeyTable_;
+        std::pmr::memory_resource* pResource_;
+        std::unordered_map<std::string_view, Key> keys_;
+    };
+
+    // shapes of the records parsed from one document, its keys come from the document's KeyCache so equal key
+    // sets are found by the addresses of their names
+    class ShapeCache
+    {
+    public:
+        explicit ShapeCache(std::pmr::memory_resource* pResource);
+        std::shared_ptr<const Shape> get(std::vector<Key>&& keys);
+        size_t size() const;
+        void clear();
+
+    private:
+        std::pmr::memory_resource* pResource_;
+        std::unordered_map<size_t, std::vector<std::shared_ptr<const Shape>>> shapes_;
+        size_t size_ = 0;
+    };
+
+    // container being parsed, its elements start at first on the value stack or the field stack
+    struct ParseFrame
+    {
+        char endChar;
+        size_t first;
+        const Key* pKey;    // key of the object member being parsed
+    };
+
+    // state of parsing, a Parser keeps one for all its documents, the scratch stacks hold the elements and fields of
+    // the containers still being parsed so the containers themselves are allocated once with their final size
+    struct ParseContext
+    {
+        explicit ParseContext(const ParseOptions& parseOptions);
+        void reset();
+
+        static constexpr size_t maxCachedKeys = 4096;
+        static constexpr size_t maxCachedShapes = 1024;
+
+        ParseOptions options;
+        KeyCache keyCache;
+        ShapeCache shapeCache;
+        std::vector<ParseFrame> frames;
+        std::vector<Variant> values;
+        std::vector<std::pair<Key, Variant>> fields;
+        std::vector<int64_t> integers;
+        std::vector<double> doubles;
+        const char* pEnd = nullptr;
+        const char* pError = nullptr;
+        ParseErrorCode errorCode = ParseErrorCode::None;
+    };
+
+    class JsonParser
+    {
+    public:
+        static ParseResult parse(std::string_view jsonStr, Variant& jsonVariant, ParseContext& context) noexcept;
+
+    private:
+        // every parse function returns false after recording the error and its position in the context
+        static bool fail(ParseContext& context, ParseErrorCode code, const char* pData);
+        static bool parseDocument(const char*& pData, ParseContext& context, Variant& variant);
+        static void closeContainer(ParseContext& context, Variant& variant);
+        static bool parseNumberArray(const char*& pData, ParseContext& context, Variant& variant);
+        static bool collectNumbers(const char*& pData, ParseContext& context);
+        static bool parseKey(const char*& pData, ParseContext& context, const Key*& pKey);
+        static bool nextElement(const char*& pData, ParseContext& context, char endChar, bool& finished);
+        static bool parseScalar(const char*& pData, ParseContext& context, Variant& variant);
+        static bool skipString(const char*& pData, ParseContext& context);
+        static bool parseLiteral(const char*& pData, ParseContext& context, Variant& variant);
+        static bool parseNumber(const char*& pData, ParseContext& context, Variant& variant);
+        static char peek(const char* pData, const ParseContext& context);
+        static void skipWhitespace(const char*& pData, const ParseContext& context);
+        static bool isIgnorable(char d);
+    };
+
+    class FormatValidator
+    {
+    public:
+        typedef bool (*Check)(std::string_view value);
+        static Check fromName(const std::string& format);
+
+        static bool isDateTime(std::string_view value);
+        static bool isDate(std::string_view value);
+        static bool isTime(std::string_view value);
+        static bool isEmail(std::string_view value);
+        static bool isHostname(std::string_view value);
+        static bool isIpv4(std::string_view value);
+        static bool isIpv6(std::string_view value);
+        static bool isUri(std::string_view value);
+        static bool isUuid(std::string_view value);
+        static bool isJsonPointer(std::string_view value);
+
+    private:
+        static bool isDigit(char c);
+        static bool isAlpha(char c);
+        static bool isHexDigit(char c);
+        static bool readDigits(std::string_view value, size_t& pos, size_t count, int& number);
+        static bool readDate(std::string_view value, size_t& pos);
+        static bool readTime(std::string_view value, size_t& pos);
+    };
+
+    struct VariantHash
+    {
+        size_t operator()(const Variant* pVariant) const;
+    };
+
+    struct VariantEqual
+    {
+        bool operator()(const Variant* pLeft, const Variant* pRight) const;
+    };
+
+    // schema with everything which can be computed ahead of validation, regular expressions, enum hash sets and
+    // combinator branches ordered by their cost, it is immutable after construction and can be shared by threads
+    class PreparedSchema
+    {
+    public:
+        struct Node
+        {
+            std::optional<std::regex> pattern;
+            bool invalidPattern = false;
+            std::vector<std::pair<std::regex, const Variant*>> patternProperties;
+            bool invalidPatternProperties = false;
+            std::unordered_set<const Variant*, VariantHash, VariantEqual> enumValues;
+            std::vector<const VariantMap*> anyOf;
+            std::vector<const VariantMap*> oneOf;
+            FormatValidator::Check format = nullptr;
+        };
+
+
+        explicit PreparedSchema(const Variant& schemaVariant);
+        explicit PreparedSchema(Variant&& schemaVariant);
+
+        const Variant& schema() const;
+        const Node* node(const VariantMap& schemaVariantMap) const;
+
+    private:
+        void prepare(const Variant& variant);
+        void prepareNode(const VariantMap& schemaVariantMap);
+        static size_t cost(const Variant& variant);
+        static std::vector<const VariantMap*> orderedBranches(const VariantVector& branches);
+
+        static constexpr size_t hashedEnumThreshold = 8;
+
+        Variant ownedSchema_;
+        const Variant& schema_;
+        std::unordered_map<const VariantMap*, Node> nodes_;
+    };
+
+    // process wide cache of prepared schemas keyed by a hash of the schema text, least recently used are evicted
+    class PreparedSchemaCache
+    {
+    public:
+        static PreparedSchemaCache& instance();
+        std::shared_ptr<const PreparedSchema> get(const std::string& schemaText, ParseResult& result);   // null for malformed schema text
+        void setCapacity(size_t capacity);
+        size_t capacity();
+        SchemaCacheStats stats();
+        void clear();
+
+    private:
+        struct Entry
+        {
+            uint64_t hash;
+            std::string schemaText;
+            std::shared_ptr<const PreparedSchema> preparedSchema;
+        };
+
+        static uint64_t hashText(std::string_view text);
+        void evict();
+
+        std::mutex mutex_;
+        std::list<Entry> entries_;  // most recently used first
+        std::unordered_map<uint64_t, std::list<Entry>::iterator> index_;
+        size_t capacity_ = 64;
+        uint64_t hits_ = 0;
+        uint64_t misses_ = 0;
+        uint64_t evictions_ = 0;
+    };
+
+    class SchemaValidator
+    {
+    public:
+        SchemaValidator(const PreparedSchema& preparedSchema, ValidationResult* pResult);
+        static bool validate(const Variant& schemaVariant, const Variant& jsonVariant, ValidationResult& result);
+        static bool validate(const PreparedSchema& preparedSchema, const Variant& jsonVariant, ValidationResult& result);
+
+    private:
+        bool collectAll() const;
+        bool report(ValidationErrorCode code, const char* keyword, const char* message);
+        bool schemaError(const char* keyword, const char* message);
+        bool probe(const VariantMap& schemaVariantMap, const Variant& jsonVariant);
+        const Variant* valueFromMap(const VariantMap& schemaVariantMap, const char* key, Type type);
+        bool compare(const VariantMap& schemaVariantMap, const Variant& jsonVariant);
+        void appendPath(std::string_view key);
+        bool compareAt(const VariantMap& schemaVariantMap, const Variant& jsonVariant, std::string_view key);
+        bool compareAt(const VariantMap& schemaVariantMap, const Variant& jsonVariant, size_t index);
+        bool checkType(const Variant& typeVariant, const Variant& jsonVariant);
+        static bool typeMatches(const std::string& typeStr, const Variant& jsonVariant);
+        bool compareEnum(const VariantMap& schemaVariantMap, const Variant& jsonVariant, const PreparedSchema::Node* pNode);
+        bool compareCombinators(const VariantMap& schemaVariantMap, const Variant& jsonVariant, const PreparedSchema::Node* pNode);
+        bool compareMap(const VariantMap& schemaVariantMap, const Variant& jsonVariant, const PreparedSchema::Node* pNode);
+        bool compareVector(const VariantMap& schemaVariantMap, const Variant& jsonVariant);
+        bool compareItemsParallel(const VariantMap& itemSchemaVariantMap, const VariantVector& variantVector);
+        bool compareString(const VariantMap& schemaVariantMap, const Variant& jsonVariant, const PreparedSchema::Node* pNode);
+        bool compareNumber(const VariantMap& schemaVariantMap, const Variant& jsonVariant);
+        const VariantMap* fromRef(const std::string& refPath);
+        static std::vector<std::string> tokenize(const std::string& str, char delim);
+
+        static constexpr size_t parallelItemsThreshold = 4096;
+        static constexpr size_t parallelChunkSize = 256;
+
+        const PreparedSchema& preparedSchema_;
+        const VariantMap& wholeSchemaVariantMap_;
+        ValidationResult* pResult_;     // nullptr when only probing whether a branch matches
+        size_t failures_;
+        std::string path_;
+    };
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+    JSON_VARIANT_INLINE WorkerPool& WorkerPool::instance()
+    {
+        static WorkerPool pool;
+        return pool;
+    }
+
+    JSON_VARIANT_INLINE WorkerPool::WorkerPool()
+    {
+        unsigned int threads = std::thread::hardware_concurrency();
+        for (unsigned int i = 1; i < threads; i++)
+            workers_.emplace_back(&WorkerPool::workerLoop, this);
+    }
+
+    JSON_VARIANT_INLINE WorkerPool::~WorkerPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+
+        wakeUp_.notify_all();
+        for (std::thread& worker : workers_)
+            worker.join();
+    }
+
+    JSON_VARIANT_INLINE size_t WorkerPool::size() const
+    {
+        return workers_.size();
+    }
+
+    JSON_VARIANT_INLINE void WorkerPool::workerLoop()
+    {
+        insideParallelJob = true;
+        for (;;)
+        {
+            std::shared_ptr<Job> job;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                wakeUp_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+                if (queue_.empty())
+                    return;
+
+                job = std::move(queue_.front());
+                queue_.pop_front();
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(job->mutex);
+                if (job->closed)
+                    continue;
+
+                ++job->active;
+            }
+
+            execute(*job);
+            {
+                std::lock_guard<std::mutex> lock(job->mutex);
+                --job->active;
+            }
+
+            job->finished.notify_all();
+        }
+    }
+
+    JSON_VARIANT_INLINE void WorkerPool::execute(Job& job) noexcept
+    {
+        // the other helpers still finish their part, the caller rethrows once all of them left the body
+        try
+        {
+            job.body();
+        }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> lock(job.mutex);
+            if (!job.error)
+                job.error = std::current_exception();
+        }
+    }
+
+    JSON_VARIANT_INLINE void WorkerPool::run(std::function<void()> body, size_t helpers)
+    {
+        // the caller always works on the job too, helpers which did not start before it finished are skipped
+        auto job = std::make_shared<Job>();
+        job->body = std::move(body);
+        {
+            // the body refers to the frame of the caller, so however run is left no helper may still be in it
+            struct JobScope
+            {
+                Job& job;
+                ~JobScope()
+                {
+                    std::unique_lock<std::mutex> lock(job.mutex);
+                    job.closed = true;
+                    job.finished.wait(lock, [this] { return job.active == 0; });
+                    insideParallelJob = false;
+                }
+            } scope{ *job };
+
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                for (size_t i = 0; i < helpers; i++)
+                    queue_.push_back(job);
+            }
+
+            wakeUp_.notify_all();
+            insideParallelJob = true;
+            execute(*job);
+        }
+
+        if (job->error)
+            std::rethrow_exception(job->error);
+    }
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifdef JSON_VARIANT_STATS
+    JSON_VARIANT_INLINE void countAllocation(size_t bytes) noexcept
+    {
+        allocationCount++;
+        allocationBytes += bytes;
+    }
+
+    JSON_VARIANT_INLINE OperationScope::OperationScope(Operation operation)
+    : enabled_(instrumentationEnabled.load(std::memory_order_relaxed))
+    {
+        if (!enabled_)
+            return;
+
+        // allocations are only counted while some scope collects
+        collectingOperations++;
+        stats_.operation = operation;
+        stats_.allocations = allocationCount;
+        stats_.allocatedBytes = allocationBytes;
+        start_ = std::chrono::steady_clock::now();
+    }
+
+    JSON_VARIANT_INLINE OperationScope::~OperationScope()
+    {
+        if (enabled_)
+            collectingOperations--;
+    }
+
+    JSON_VARIANT_INLINE void OperationScope::finish(bool succeeded, size_t bytes, const Variant* pDocument)
+    {
+        if (!enabled_)
+            return;
+
+        stats_.elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start_);
+        stats_.allocations = allocationCount - stats_.allocations;
+        stats_.allocatedBytes = allocationBytes - stats_.allocatedBytes;
+        stats_.succeeded = succeeded;
+        stats_.bytes = bytes;
+        if (pDocument)
+            collectNodes(*pDocument, stats_);
+
+        lastOperationStats = stats_;
+        std::shared_ptr<const Instrumentation::Callback> pCallback;
+        {
+            std::lock_guard<std::mutex> lock(instrumentationMutex);
+            pCallback = pInstrumentationCallback;
+        }
+
+        if (pCallback)
+            (*pCallback)(stats_);
+    }
+
+    JSON_VARIANT_INLINE void OperationScope::collectNodes(const Variant& document, OperationStats& stats)
+    {
+        std::vector<std::pair<const Variant*, size_t>> pending{ { &document, 1 } };
+        while (!pending.empty())
+        {
+            auto [pVariant, depth] = pending.back();
+            pending.pop_back();
+            stats.nodes[size_t(pVariant->type())]++;
+            stats.maxDepth = std::max(stats.maxDepth, depth);
+            if (pVariant->type() == Type::Vector)
+            {
+                for (const Variant& child : pVariant->toVector())
+                    pending.emplace_back(&child, depth + 1);
+            }
+            else if (pVariant->type() == Type::Map)
+            {
+                for (const auto& it : pVariant->toMap())
+                    pending.emplace_back(&it.second, depth + 1);
+            }
+            else if (pVariant->type() == Type::Record)
+            {
+                for (const Variant& child : pVariant->recordValues())
+                    pending.emplace_back(&child, depth + 1);
+            }
+        }
+    }
+#endif
+
+    JSON_VARIANT_INLINE bool DocumentScanner::feed(std::string_view chunk)
+    {
+        for (char c : chunk)
+        {
+            size_++;
+            if (!started_ && !isIgnorable(c) && c != '{' && c != '[')
+                return true;
+
+            if (inString_)
+            {
+                if (escaped_)
+                    escaped_ = false;
+                else if (c == '\\')
+                    escaped_ = true;
+                else if (c == '\"')
+                    inString_ = false;
+            }
+            else if (c == '\"')
+                inString_ = true;
+            else if (c == '{' || c == '[')
+            {
+                depth_++;
+                started_ = true;
+            }
+            else if ((c == '}' || c == ']') && --depth_ == 0)
+                return true;
+        }
+
+        return false;
+    }
+
+    JSON_VARIANT_INLINE size_t DocumentScanner::size() const
+    {
+        return size_;
+    }
+
+    JSON_VARIANT_INLINE MappedFile::MappedFile(const std::string& path)
+    {
+#ifdef _WIN32
+        std::ifstream file(path, std::ios::binary);
+        if (!file)
+            return;
+
+        content_.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        pData_ = content_.data();
+        size_ = content_.size();
+        isOpen_ = !file.bad();
+#else
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+            return;
+
+        struct stat fileStat;
+        if (::fstat(fd, &fileStat) == 0 && S_ISREG(fileStat.st_mode))
+        {
+            size_ = (size_t)fileStat.st_size;
+            isOpen_ = true;
+            if (size_ > 0)
+            {
+                // the parser reads the file once from the start to the end
+                void* pMapping = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (pMapping == MAP_FAILED)
+                {
+                    isOpen_ = false;
+                    size_ = 0;
+                }
+                else
+                {
+                    ::madvise(pMapping, size_, MADV_SEQUENTIAL);
+                    pData_ = static_cast<const char*>(pMapping);
+                }
+            }
+        }
+
+        ::close(fd);
+#endif
+    }
+
+    JSON_VARIANT_INLINE MappedFile::~MappedFile()
+    {
+#ifndef _WIN32
+        if (pData_)
+            ::munmap(const_cast<char*>(pData_), size_);
+#endif
+    }
+
+    JSON_VARIANT_INLINE bool MappedFile::isOpen() const
+    {
+        return isOpen_;
+    }
+
+    JSON_VARIANT_INLINE std::string_view MappedFile::view() const
+    {
+        return std::string_view(pData_ ? pData_ : "", size_);
+    }
+
+    JSON_VARIANT_INLINE BackgroundReleaser& BackgroundReleaser::instance()
+    {
+        // leaked so the mutex outlives the statics whose destructors still release documents, the exit handler runs
+        // where the destructor of a static made here would
+        static BackgroundReleaser* pReleaser = []
+        {
+            BackgroundReleaser* pNew = new BackgroundReleaser;
+            std::atexit([] { instance().stop(); });
+            return pNew;
+        }();
+
+        return *pReleaser;
+    }
+
+    JSON_VARIANT_INLINE void BackgroundReleaser::stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+
+        wakeUp_.notify_all();
+        if (thread_.joinable())
+            thread_.join();
+    }
+
+    JSON_VARIANT_INLINE bool BackgroundReleaser::release(Variant&& variant)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (stopping_)
+                return false;
+
+            if (!thread_.joinable())
+            {
+                try
+                {
+                    thread_ = std::thread(&BackgroundReleaser::releaseLoop, this);
+                }
+                catch (const std::system_error&)
+                {
+                    return false;
+                }
+            }
+
+            queue_.push_back(std::move(variant));
+        }
+
+        wakeUp_.notify_one();
+        return true;
+    }
+
+    JSON_VARIANT_INLINE void BackgroundReleaser::releaseLoop()
+    {
+        std::vector<Variant> released;
+        for (;;)
+        {
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                wakeUp_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+                if (queue_.empty())
+                    return;
+
+                released.swap(queue_);
+            }
+
+            // freed outside of the lock so request threads are never blocked by the teardown
+            released.clear();
+        }
+    }
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+    JSON_VARIANT_INLINE KeyCache::KeyCache(KeyTable* pKeyTable, std::pmr::memory_resource* pResource)
+    : pKeyTable_(pKeyTable),
+      pResource_(pResource)
+    {
+    }
+
+    JSON_VARIANT_INLINE const Key& KeyCache::get(std::string_view name)
+    {
+        auto it = keys_.find(name);
+        if (it != keys_.end())
+            return it->second;
+
+        MemoryScope memory(pResource_);
+        Key key = pKeyTable_ ? pKeyTable_->intern(name) : Key(name);
+        std::string_view keyName = key.str();
+        return keys_.emplace(keyName, std::move(key)).first->second;
+    }
+
+    JSON_VARIANT_INLINE size_t KeyCache::size() const
+    {
+        return keys_.size();
+    }
+
+    JSON_VARIANT_INLINE void KeyCache::clear()
+    {
+        keys_.clear();
+    }
+
+    JSON_VARIANT_INLINE ShapeCache::ShapeCache(std::pmr::memory_resource* pResource)
+    : pResource_(pResource)
+    {
+    }
+
+    JSON_VARIANT_INLINE std::shared_ptr<const Shape> ShapeCache::get(std::vector<Key>&& keys)
+    {
+        size_t hash = keys.size();
+        for (const Key& key : keys)
+            hash ^= std::hash<const void*>()(&key.str()) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+
+        std::vector<std::shared_ptr<const Shape>>& candidates = shapes_[hash];
+        for (const std::shared_ptr<const Shape>& pShape : candidates)
+        {
+            if (pShape->size() != keys.size())
+                continue;
+
+            size_t i = 0;
+            while (i < keys.size() && pShape->key(i) == keys[i])
+                i++;
+
+            if (i == keys.size())
+                return pShape;
+        }
+
+        candidates.push_back(std::allocate_shared<Shape>(ScopedAllocator<Shape>(pResource_), std::move(keys)));
+        size_++;
+        return candidates.back();
+    }
+
+    JSON_VARIANT_INLINE size_t ShapeCache::size() const
+    {
+        return size_;
+    }
+
+    JSON_VARIANT_INLINE void ShapeCache::clear()
+    {
+        shapes_.clear();
+        size_ = 0;
+    }
+
+    JSON_VARIANT_INLINE ParseContext::ParseContext(const ParseOptions& parseOptions)
+    : options(parseOptions),
+      keyCache(parseOptions.pKeyTable, parseOptions.pMemoryResource ? parseOptions.pMemoryResource : MemoryScope::current()),
+      shapeCache(parseOptions.pMemoryResource ? parseOptions.pMemoryResource : MemoryScope::current())
+    {
+        frames.reserve(std::min<size_t>(options.maxDepth, 64));
+    }
+
+    JSON_VARIANT_INLINE void ParseContext::reset()
+    {
+        // the caches are bounded so documents with ever new keys do not grow them without limit, shapes hold on to
+        // their keys and are dropped with them
+        if (keyCache.size() > maxCachedKeys || shapeCache.size() > maxCachedShapes)
+        {
+            keyCache.clear();
+            shapeCache.clear();
+        }
+
+        values.clear();
+        fields.clear();
+        errorCode = ParseErrorCode::None;
+        pError = nullptr;
+    }
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+    JSON_VARIANT_INLINE bool JsonParser::isIgnorable(char d)
+    {
+        return (d == ' ' || d == '\n' || d == '\t' || d == '\r');
+    }
+
+    JSON_VARIANT_INLINE char JsonParser::peek(const char* pData, const ParseContext& context)
+    {
+        return pData < context.pEnd ? *pData : '\0';
+    }
+
+    JSON_VARIANT_INLINE void JsonParser::skipWhitespace(const char*& pData, const ParseContext& context)
+    {
+        while (pData < context.pEnd && isIgnorable(*pData))
+            ++pData;
+    }
+
+    JSON_VARIANT_INLINE bool JsonParser::fail(ParseContext& context, ParseErrorCode code, const char* pData)
+    {
+        context.errorCode = (pData < context.pEnd) ? code : ParseErrorCode::UnfinishedDocument;
+        context.pError = pData;
+        return false;
+    }
+
+    JSON_VARIANT_INLINE bool JsonParser::skipString(const char*& pData, ParseContext& context)
+    {
+        // escapes are kept as they are written, only the escaped character is checked
+        const char* pStart = pData++;
+        while (pData < context.pEnd)
+        {
+            char c = *pData;
+            if (c == '\"')
+            {
+                ++pData;
+                return true;
+            }
+
+            if (c == '\\')
+            {
+                switch (peek(pData + 1, context))
+                {
+                case '"':  // Escape double quotes
+                case '\\': // Escape backslashes
+                case 'n':  // Escape newlines
+                case 'r':  // Escape carriage return
+                case 't':  // Escape tabs
+                case 'b':  // Escape backspace
+                case 'f':  // Escape form feed
+                    ++pData;
+                    break;
+                default:
+                    return fail(context, ParseErrorCode::InvalidEscape, pData);
+                }
+            }
+
+            ++pData;
+        }
+
+        return fail(context, ParseErrorCode::UnfinishedString, pStart);
+    }
+
+    JSON_VARIANT_INLINE bool JsonParser::parseLiteral(const char*& pData, ParseContext& context, Variant& variant)
+    {
+        std::string_view rest(pData, context.pEnd - pData);
+        if (rest.starts_with("true"))
+        {
+            variant = Variant(true);
+            pData += 4;
+        }
+        else if (rest.starts_with("false"))
+        {
+            variant = Variant(false);
+            pData += 5;
+        }
+        else if (rest.starts_with("null"))
+        {
+            variant = Variant(nullptr);
+            pData += 4;
+        }
+        else
+        {
+            return fail(context, ParseErrorCode::InvalidLiteral, pData);
+        }
+
+        return true;
+    }
+
+    JSON_VARIANT_INLINE bool JsonParser::parseNumber(const char*& pData, ParseContext& context, Variant& variant)
+    {
+        // integral literals are accumulated directly, anything with fraction, exponent or overflow is a double
+        const char* pStart = pData;
+        bool negative = (peek(pData, context) == '-');
+        if (negative)
+            ++pData;
+
+        uint64_t magnitude = 0;
+        bool overflow = false;
+        const char* pDigits = pData;
+        while (isdigit(peek(pData, context)))
+        {
+            unsigned digit = *pData - '0';
+            if (magnitude > (std::numeric_limits<uint64_t>::max() - digit) / 10)
+                overflow = true;
+            else
+                magnitude = magnitude * 10 + digit;
+
+            ++pData;
+        }
+
+        bool integral = true;
+        if (peek(pData, context) == '.')
+        {
+            integral = false;
+            ++pData;
+            while (isdigit(peek(pData, context)))
+                ++pData;
+        }
+
+        if (peek(pData, context) == 'e' || peek(pData, context) == 'E')
+        {
+            integral = false;
+            ++pData;
+            if (peek(pData, context) == '+' || peek(pData, context) == '-')
+                ++pData;
+
+            while (isdigit(peek(pData, context)))
+                ++pData;
+        }
+
+        if (integral && pDigits != pData && !overflow)
+        {
+            if (!negative)
+            {
+                variant = Variant((unsigned long long)magnitude);
+                return true;
+            }
+
+            if (magnitude <= (uint64_t)std::numeric_limits<int64_t>::max() + 1)
+            {
+                variant = Variant((long long)(0 - magnitude));
+                return true;
+            }
+        }
+
+        double d;
+        auto result = std::from_chars(pStart, pData, d);
+        if (result.ec == std::errc::result_out_of_range)
+            return fail(context, ParseErrorCode::NumberOutOfRange, pStart);
+
+        if (result.ec != std::errc() || result.ptr != pData)
+            return fail(context, ParseErrorCode::InvalidNumber, pStart);
+
+        variant = Variant(d);
+        return true;
+    }
+
+    JSON_VARIANT_INLINE bool JsonParser::parseScalar(const char*& pData, ParseContext& context, Variant& variant)
+    {
+        char c = peek(pData, context);
+        if (c == '\"')
+        {
+            const char* pStart = pData;
+            if (!skipString(pData, context))
+                return false;
+
+            variant = Variant(std::string(pStart + 1, pData - 1));
+            return true;
+        }
+
+        if (c == 't' || c == 'f' || c == 'n')
+            return parseLiteral(pData, context, variant);
+
+        if (isdigit(c) || c == '-')
+            return parseNumber(pData, context, variant);
+
+        return fail(context, ParseErrorCode::UnexpectedCharacter, pData);
+    }
+
+    JSON_VARIANT_INLINE bool JsonParser::parseKey(const char*& pData, ParseContext& context, const Key*& pKey)
+    {
+        if (peek(pData, context) != '\"')
+            return fail(context, ParseErrorCode::InvalidKey, pData);
+
+        const char* pStart = pData;
+        if (!skipString(pData, context))
+            return false;
+
+        pKey = &context.keyCache.get(std::string_view(pStart + 1, pData - pStart - 2));
+        skipWhitespace(pData, context);
+        if (peek(pData, context) != ':')
+            return fail(context, ParseErrorCode::MissingColon, pData);
+
+        ++pData;
+        skipWhitespace(pData, context);
+        return true;
+    }
+
+    JSON_VARIANT_INLINE bool JsonParser::nextElement(const char*& pData, ParseContext& context, char endChar, bool& finished)
+    {
+        skipWhitespace(pData, context);
+        char c = peek(pData, context);
+        finished = (c == endChar);
+        if (!finished && c != ',')
+            return fail(context, ParseErrorCode::MissingDelimiter, pData);
+
+        ++pData;
+        if (!finished)
+            skipWhitespace(pData, context);
+
+        return true;
+    }
+
+    JSON_VARIANT_INLINE bool JsonParser::parseNumberArray(const char*& pData, ParseContext& context, Variant& variant)
+    {
+        // anything else than a flat array of numbers is left to be parsed again as a plain array
+        const char* pStart = pData;
+        if (collectNumbers(pData, context))
+        {
+            if (context.doubles.empty())
+                variant = Variant::numberArray(std::vector<int64_t>(context.integers.begin(), context.integers.end()));
+            else
+                variant = Variant::numberArray(std::vector<double>(context.doubles.begin(), context.doubles.end()));
+
+            return true;
+        }
+
+        context.errorCode = ParseErrorCode::None;
+        pData = pStart;
+        return false;
+    }
+
+    JSON_VARIANT_INLINE bool JsonParser::collectNumbers(const char*& pData, ParseContext& context)
+    {
+        // integers are collected until the first double, every integer has to be exact as a double from then on
+        constexpr int64_t exactDoubleLimit = int64_t(1) << 53;
+        std::vector<int64_t>& integers = context.integers;
+        std::vector<double>& doubles = context.doubles;
+        integers.clear();
+        doubles.clear();
+        bool isDouble = false;
+        for (;;)
+        {
+            char c = peek(pData, context);
+            Variant number;
+            if ((!isdigit(c) && c != '-') || !parseNumber(pData, context, number) || number.numberType() == NumberType::UInt64)
+                return false;
+
+            if (number.numberType() == NumberType::Double && !isDouble)
+            {
+                for (int64_t integer : integers)
+                {
+                    if (integer > exactDoubleLimit || integer < -exactDoubleLimit)
+                        return false;
+                }
+
+                doubles.assign(integers.begin(), integers.end());
+                isDouble = true;
+            }
+
+            if (!isDouble)
+                integers.push_back(number.toInt64());
+            else if (number.numberType() == NumberType::Double)
+                doubles.push_back(number.toDouble());
+            else if (number.toInt64() <= exactDoubleLimit && number.toInt64() >= -exactDoubleLimit)
+                doubles.push_back(number.toDouble());
+            else
+                return false;
+
+            bool finished = false;
+            if (!nextElement(pData, context, ']', finished))
+                return false;
+
+            if (finished)
+                return true;
+        }
+    }
+
+    JSON_VARIANT_INLINE void JsonParser::closeContainer(ParseContext& context, Variant& variant)
+    {
+        ParseFrame frame = context.frames.back();
+        context.frames.pop_back();
+        if (frame.endChar == ']')
+        {
+            VariantVector variantVector(std::make_move_iterator(context.values.begin() + frame.first), std::make_move_iterator(context.values.end()));
+            context.values.resize(frame.first);
+            variant = Variant(std::move(variantVector));
+            return;
+        }
+
+        auto fieldsBegin = context.fields.begin() + frame.first;
+        if (!context.options.shareShapes)
+        {
+            VariantMap variantMap;
+            for (auto it = fieldsBegin; it != context.fields.end(); ++it)
+                variantMap.emplace(std::move(it->first), std::move(it->second));
+
+            context.fields.resize(frame.first);
+            variant = Variant(std::move(variantMap));
+            return;
+        }
+
+        // ordered as a map would be, the first of duplicated keys wins like with map emplace
+        std::stable_sort(fieldsBegin, context.fields.end(), [](const auto& left, const auto& right) { return left.first < right.first; });
+        std::vector<Key> keys;
+        VariantVector values;
+        keys.reserve(context.fields.end() - fieldsBegin);
+        values.reserve(context.fields.end() - fieldsBegin);
+        for (auto it = fieldsBegin; it != context.fields.end(); ++it)
+        {
+            if (!keys.empty() && keys.back() == it->first)
+                continue;
+
+            keys.push_back(std::move(it->first));
+            values.push_back(std::move(it->second));
+        }
+
+        context.fields.resize(frame.first);
+        variant = Variant::record(context.shapeCache.get(std::move(keys)), std::move(values));
+    }
+
+    JSON_VARIANT_INLINE bool JsonParser::parseDocument(const char*& pData, ParseContext& context, Variant& variant)
+    {
+        // open containers are kept on the frame stack and their elements on the value and field stacks, so nesting
+        // costs no native stack and is bounded by ParseOptions::maxDepth
+        std::vector<ParseFrame>& frames = context.frames;
+        frames.clear();
+        for (;;)
+        {
+            char c = peek(pData, context);
+            if (c == '{' || c == '[')
+            {
+                if (frames.size() >= context.options.maxDepth)
+                    return fail(context, ParseErrorCode::NestingTooDeep, pData);
+
+                ++pData;
+                skipWhitespace(pData, context);
+                bool isArray = (c == '[');
+                if (!isArray || !context.options.typedArrays || !parseNumberArray(pData, context, variant))
+                {
+                    frames.push_back(ParseFrame{ isArray ? ']' : '}', isArray ? context.values.size() : context.fields.size(), nullptr });
+                    if (peek(pData, context) == frames.back().endChar)
+                    {
+                        ++pData;
+                        closeContainer(context, variant);
+                    }
+                    else if (!isArray && !parseKey(pData, context, frames.back().pKey))
+                        return false;
+                    else
+                        continue;
+                }
+            }
+            else if (!parseScalar(pData, context, variant))
+            {
+                return false;
+            }
+
+            // the finished value goes to its container, which may be finished by it as well
+            for (;;)
+            {
+                if (frames.empty())
+                    return true;
+
+                ParseFrame& frame = frames.back();
+                if (frame.endChar == ']')
+                    context.values.push_back(std::move(variant));
+                else
+                    context.fields.emplace_back(*frame.pKey, std::move(variant));
+
+                bool finished = false;
+                if (!nextElement(pData, context, frame.endChar, finished))
+                    return false;
+
+                if (!finished)
+                {
+                    if (frame.endChar == '}' && !parseKey(pData, context, frame.pKey))
+                        return false;
+
+                    break;
+                }
+
+                closeContainer(context, variant);
+            }
+        }
+    }
+
+    JSON_VARIANT_INLINE ParseResult JsonParser::parse(std::string_view jsonStr, Variant& jsonVariant, ParseContext& context) noexcept
+    {
+        context.reset();
+        const char* pData = jsonStr.data();
+        context.pEnd = pData + jsonStr.size();
+        MemoryScope memory(context.options.pMemoryResource ? context.options.pMemoryResource : MemoryScope::current());
+        OperationScope scope(Operation::Parse);
+        try
+        {
+            // the document is an object or an array, nothing but whitespace may follow it
+            Variant variant;
+            skipWhitespace(pData, context);
+            if (jsonStr.size() > context.options.maxDocumentSize)
+            {
+                context.errorCode = ParseErrorCode::DocumentTooLarge;
+                context.pError = jsonStr.data();
+            }
+            else if (peek(pData, context) != '{' && peek(pData, context) != '[')
+                fail(context, ParseErrorCode::InvalidRoot, pData);
+            else if (parseDocument(pData, context, variant))
+            {
+                skipWhitespace(pData, context);
+                if (pData != context.pEnd)
+                    fail(context, ParseErrorCode::TrailingCharacters, pData);
+                else
+                    jsonVariant = std::move(variant);
+            }
+        }
+        catch (const std::bad_alloc&)
+        {
+            context.errorCode = ParseErrorCode::OutOfMemory;
+            context.pError = pData;
+        }
+
+        bool succeeded = (context.errorCode == ParseErrorCode::None);
+        scope.finish(succeeded, jsonStr.size(), succeeded ? &jsonVariant : nullptr);
+        ParseResult result;
+        if (succeeded)
+            return result;
+
+        // line and column are only counted for failed documents
+        std::string_view parsed = jsonStr.substr(0, context.pError - jsonStr.data());
+        size_t lineStart = parsed.rfind('\n');
+        result.code = context.errorCode;
+        result.offset = parsed.size();
+        result.line = 1 + std::count(parsed.begin(), parsed.end(), '\n');
+        result.column = parsed.size() - (lineStart == std::string_view::npos ? 0 : lineStart + 1) + 1;
+        return result;
+    }
+    
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    JSON_VARIANT_INLINE bool FormatValidator::isDigit(char c)
+    {
+        return c >= '0' && c <= '9';
+    }
+
+    JSON_VARIANT_INLINE bool FormatValidator::isAlpha(char c)
+    {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+    }
+
+    JSON_VARIANT_INLINE bool FormatValidator::isHexDigit(char c)
+    {
+        return isDigit(c) || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+    }
+
+    JSON_VARIANT_INLINE bool FormatValidator::readDigits(std::string_view value, size_t& pos, size_t count, int& number)
+    {
+        if (value.size() - pos < count)
+            return false;
+
+        number = 0;
+        for (size_t i = 0; i < count; i++, pos++)
+        {
+            if (!isDigit(value[pos]))
+                return false;
+
+            number = number * 10 + (value[pos] - '0');
+        }
+
+        return true;
+    }
+
+    JSON_VARIANT_INLINE bool FormatValidator::readDate(std::string_view value, size_t& pos)
+    {
+        // full-date from RFC 3339, day is checked against the month including leap years
+        static const int daysInMonth[] = { 31, 29, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+        int year, month, day;
+        if (!readDigits(value, pos, 4, year) || pos >= value.size() || value[pos++] != '-')
+            return false;
+
+        if (!readDigits(value, pos, 2, month) || pos >= value.size() || value[pos++] != '-')
+            return false;
+
+        if (!readDigits(value, pos, 2, day) || month < 1 || month > 12 || day < 1 || day > daysInMonth[month - 1])
+            return false;
+
+        bool leapYear = (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+        return month != 2 || day < 29 || leapYear;
+    }
+
+    JSON_VARIANT_INLINE bool FormatValidator::readTime(std::string_view value, size_t& pos)
+    {
+        // full-time from RFC 3339, second 60 is allowed for leap seconds
+        int hour, minute, second;
+        if (!readDigits(value, pos, 2, hour) || pos >= value.size() || value[pos++] != ':')
+            return false;
+
+        if (!readDigits(value, pos, 2, minute) || pos >= value.size() || value[pos++] != ':')
+            return false;
+
+        if (!readDigits(value, pos, 2, second) || hour > 23 || minute > 59 || second > 60)
+            return false;
+
+        if (pos < value.size() && value[pos] == '.')
+        {
+            size_t fractionStart = ++pos;
+            while (pos < value.size() && isDigit(value[pos]))
+                pos++;
+
+            if (pos == fractionStart)
+                return false;
+        }
+
+        if (pos >= value.size())
+            return false;
+
+        char c = value[pos++];
+        if (c == 'Z' || c == 'z')
+            return true;
+
+        if (c != '+' && c != '-')
+            return false;
+
+        int offsetHour, offsetMinute;
+        if (!readDigits(value, pos, 2, offsetHour) || pos >= value.size() || value[pos++] != ':')
+            return false;
+
+        return readDigits(value, pos, 2, offsetMinute) && offsetHour <= 23 && offsetMinute <= 59;
+    }
+
+    JSON_VARIANT_INLINE bool FormatValidator::isDateTime(std::string_view value)
+    {
+        size_t pos = 0;
+        if (!readDate(value, pos) || pos >= value.size() || (value[pos] != 'T' && value[pos] != 't' && value[pos] != ' '))
+            return false;
+
+        ++pos;
+        return readTime(value, pos) && pos == value.size();
+    }
+
+    JSON_VARIANT_INLINE bool FormatValidator::isDate(std::string_view value)
+    {
+        size_t pos = 0;
+        return readDate(value, pos) && pos == value.size();
+    }
+
+    JSON_VARIANT_INLINE bool FormatValidator::isTime(std::string_view value)
+    {
+        size_t pos = 0;
+        return readTime(value, pos) && pos == value.size();
+    }
+
+    JSON_VARIANT_INLINE bool FormatValidator::isHostname(std::string_view value)
+    {
+        // RFC 1123, labels of letters, digits and hyphens which neither start nor end with a hyphen
+        if (value.empty() || value.size() > 253)
+            return false;
+
+        size_t labelLength = 0;
+        for (size_t i = 0; i < value.size(); i++)
+        {
+            char c = value[i];
+            if (c == '.')
+            {
+                if (labelLength == 0 || value[i - 1] == '-')
+                    return false;
+
+                labelLength = 0;
+            }
+            else if (isAlpha(c) || isDigit(c) || c == '-')
+            {
+                if ((c == '-' && labelLength == 0) || ++labelLength > 63)
+                    return false;
+            }
+            else
+            {
+                return false;
+            }
+        }
+
+        return labelLength > 0 && value.back() != '-';
+    }
+
+    JSON_VARIANT_INLINE bool FormatValidator::isEmail(std::string_view value)
+    {
+        // RFC 5321 mailbox, dot-atom or quoted local part and hostname or address literal domain
+        size_t at = value.rfind('@');
+        if (at == std::string_view::npos || at == 0 || at > 64)
+            return false;
+
+        std::string_view local = value.substr(0, at);
+        std::string_view domain = value.substr(at + 1);
+        if (local.front() == '"')
+        {
+            if (local.size() < 2 || local.back() != '"')
+                return false;
+
+            for (size_t i = 1; i < local.size() - 1; i++)
+            {
+                unsigned char c = (unsigned char)local[i];
+                if (c == '\\')
+                {
+                    if (++i >= local.size() - 1 || (unsigned char)local[i] < 0x20)
+                        return false;
+                }
+                else if (c < 0x20 || c == '"' || c == 0x7f)
+                {
+                    return false;
+                }
+            }
+        }
+        else
+        {
+            static const std::string_view atextSpecials("!#$%&'*+-/=?^_`{|}~");
+            for (size_t i = 0; i < local.size(); i++)
+            {
+                char c = local[i];
+                if (c == '.')
+                {
+                    if (i == 0 || i == local.size() - 1 || local[i - 1] == '.')
+                        return false;
+                }
+                else if (!isAlpha(c) && !isDigit(c) && atextSpecials.find(c) == std::string_view::npos)
+                {
+                    return false;
+                }
+            }
+        }
+
+        if (domain.size() > 2 && domain.front() == '[' && domain.back() == ']')
+        {
+            std::string_view literal = domain.substr(1, domain.size() - 2);
+            if (literal.substr(0, 5) == "IPv6:")
+                return isIpv6(literal.substr(5));
+
+            return isIpv4(literal);
+        }
+
+        return isHostname(domain);
+    }
+
+    JSON_VARIANT_INLINE bool FormatValidator::isIpv4(std::string_view value)
+    {
+        // dotted decimal, octets without leading zeros
+        size_t pos = 0;
+        for (int octet = 0; octet < 4; octet++)
+        {
+            if (octet > 0 && (pos >= value.size() || value[pos++] != '.'))
+                return false;
+
+            size_t start = pos;
+            int number = 0;
+            while (pos < value.size() && isDigit(value[pos]) && pos - start < 3)
+                number = number * 10 + (value[pos++] - '0');
+
+            size_t length = pos - start;
+            if (length == 0 || number > 255 || (length > 1 && value[start] == '0'))
+                return false;
+        }
+
+        return pos == value.size();
+    }
+
+    JSON_VARIANT_INLINE bool FormatValidator::isIpv6(std::string_view value)
+    {
+        // RFC 4291 text form, at most one "::" and an optional trailing ipv4 address
+        int groups = 0;
+        bool compressed = false;
+        size_t pos = 0;
+        if (value.size() >= 2 && value[0] == ':' && value[1] == ':')
+        {
+            compressed = true;
+            pos = 2;
+        }
+        else if (!value.empty() && value[0] == ':')
+        {
+            return false;
+        }
+
+        while (pos < value.size())
+        {
+            size_t start = pos;
+            while (pos < value.size() && isHexDigit(value[pos]) && pos - start < 5)
+                pos++;
+
+            if (pos < value.size() && value[pos] == '.')
+            {
+                if (!isIpv4(value.substr(start)))
+                    return false;
+
+                groups += 2;
+                pos = value.size();
+                break;
+            }
+
+            size_t length = pos - start;
+            if (length == 0 || length > 4)
+                return false;
+
+            groups++;
+            if (pos == value.size())
+                break;
+
+            if (value[pos] != ':')
+                return false;
+
+            if (++pos < value.size() && value[pos] == ':')
+            {
+                if (compressed)
+                    return false;
+
+                compressed = true;
+                ++pos;
+            }
+            else if (pos == value.size())
+            {
+                return false;
+            }
+        }
+
+        return compressed ? groups <= 7 : groups == 8;
+    }
+
+    JSON_VARIANT_INLINE bool FormatValidator::isUri(std::string_view value)
+    {
+        // RFC 3986 absolute uri, scheme followed by characters allowed in a uri and valid percent encoding
+        static const std::string_view allowed("-._~!$&'()*+,;=:@/?#[]");
+        if (value.empty() || !isAlpha(value[0]))
+            return false;
+
+        size_t pos = 1;
+        while (pos < value.size() && (isAlpha(value[pos]) || isDigit(value[pos]) || value[pos] == '+' || value[pos] == '-' || value[pos] == '.'))
+            pos++;
+
+        if (pos >= value.size() || value[pos] != ':')
+            return false;
+
+        bool fragment = false;
+        for (++pos; pos < value.size(); pos++)
+        {
+            char c = value[pos];
+            if (c == '%')
+            {
+                if (pos + 2 >= value.size() || !isHexDigit(value[pos + 1]) || !isHexDigit(value[pos + 2]))
+                    return false;
+
+                pos += 2;
+            }
+            else if (c == '#')
+            {
+                if (fragment)
+                    return false;
+
+                fragment = true;
+            }
+            else if (!isAlpha(c) && !isDigit(c) && allowed.find(c) == std::string_view::npos)
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    JSON_VARIANT_INLINE bool FormatValidator::isUuid(std::string_view value)
+    {
+        // 8-4-4-4-12 hexadecimal digits
+        if (value.size() != 36)
+            return false;
+
+        for (size_t i = 0; i < value.size(); i++)
+        {
+            bool dash = (i == 8 || i == 13 || i == 18 || i == 23);
+            if (dash ? value[i] != '-' : !isHexDigit(value[i]))
+                return false;
+        }
+
+        return true;
+    }
+
+    JSON_VARIANT_INLINE bool FormatValidator::isJsonPointer(std::string_view value)
+    {
+        // RFC 6901, empty or '/' separated tokens where '~' is only used as "~0" or "~1"
+        if (!value.empty() && value[0] != '/')
+            return false;
+
+        for (size_t i = 0; i < value.size(); i++)
+        {
+            if (value[i] == '~' && (i + 1 >= value.size() || (value[i + 1] != '0' && value[i + 1] != '1')))
+                return false;
+        }
+
+        return true;
+    }
+
+    JSON_VARIANT_INLINE FormatValidator::Check FormatValidator::fromName(const std::string& format)
+    {
+        if (format == "date-time")
+            return &isDateTime;
+        else if (format == "date")
+            return &isDate;
+        else if (format == "time")
+            return &isTime;
+        else if (format == "email")
+            return &isEmail;
+        else if (format == "hostname")
+            return &isHostname;
+        else if (format == "ipv4")
+            return &isIpv4;
+        else if (format == "ipv6")
+            return &isIpv6;
+        else if (format == "uri")
+            return &isUri;
+        else if (format == "uuid")
+            return &isUuid;
+        else if (format == "json-pointer")
+            return &isJsonPointer;
+
+        return nullptr;
+    }
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    JSON_VARIANT_INLINE size_t VariantHash::operator()(const Variant* pVariant) const
+    {
+        // seeded by the logical type, a record hashes like the equal map and a typed array like the equal vector
+        const Variant& variant = *pVariant;
+        Type logicalType = variant.type();
+        if (logicalType == Type::Record)
+            logicalType = Type::Map;
+        else if (logicalType == Type::NumberArray)
+            logicalType = Type::Vector;
+
+        size_t seed = (size_t)logicalType;
+        auto combine = [&seed](size_t hash)
+        {
+            seed ^= hash + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+        };
+
+        switch (variant.type())
+        {
+        case Type::Number:
+        {
+            double value = variant.toNumber();
+            combine(std::hash<double>()(value == 0.0 ? 0.0 : value));
+        }
+        break;
+
+        case Type::Bool:
+            combine(variant.toBool() ? 1 : 0);
+            break;
+
+        case Type::String:
+            combine(std::hash<std::string_view>()(variant.toString()));
+            break;
+
+        case Type::Vector:
+            for (const Variant& v : variant.toVector())
+                combine((*this)(&v));
+            break;
+
+        case Type::NumberArray:
+        {
+            // each number the way a Type::Number element of a vector is hashed
+            auto combineNumbers = [&combine](auto numbers)
+            {
+                for (auto number : numbers)
+                {
+                    double value = (double)number;
+                    size_t elementSeed = (size_t)Type::Number;
+                    elementSeed ^= std::hash<double>()(value == 0.0 ? 0.0 : value) + 0x9e3779b9 + (elementSeed << 6) + (elementSeed >> 2);
+                    combine(elementSeed);
+                }
+            };
+
+            if (variant.numberType() == NumberType::Double)
+                combineNumbers(variant.toDoubleArray());
+            else
+                combineNumbers(variant.toInt64Array());
+        }
+        break;
+
+        case Type::Map:
+            for (const auto& it : variant.toMap())
+            {
+                combine(std::hash<std::string_view>()(it.first.str()));
+                combine((*this)(&it.second));
+            }
+            break;
+
+        case Type::Record:
+            for (size_t i = 0; i < variant.shape().size(); i++)
+            {
+                combine(std::hash<std::string_view>()(variant.shape().key(i).str()));
+                combine((*this)(&variant.recordValues()[i]));
+            }
+            break;
+
+        default:
+            break;
+        }
+
+        return seed;
+    }
+
+    JSON_VARIANT_INLINE bool VariantEqual::operator()(const Variant* pLeft, const Variant* pRight) const
+    {
+        return *pLeft == *pRight;
+    }
+
+    JSON_VARIANT_INLINE PreparedSchema::PreparedSchema(const Variant& schemaVariant)
+        : schema_(schemaVariant)
+    {
+        prepare(schema_);
+    }
+
+    JSON_VARIANT_INLINE PreparedSchema::PreparedSchema(Variant&& schemaVariant)
+        : ownedSchema_(std::move(schemaVariant)), schema_(ownedSchema_)
+    {
+        prepare(schema_);
+    }
+
+    JSON_VARIANT_INLINE const Variant& PreparedSchema::schema() const
+    {
+        return schema_;
+    }
+
+    JSON_VARIANT_INLINE const PreparedSchema::Node* PreparedSchema::node(const VariantMap& schemaVariantMap) const
+    {
+        if (nodes_.empty())
+            return nullptr;
+
+        const auto it = nodes_.find(&schemaVariantMap);
+        return (it == nodes_.end()) ? nullptr : &it->second;
+    }
+
+    JSON_VARIANT_INLINE void PreparedSchema::prepare(const Variant& variant)
+    {
+        if (variant.type() == Type::Vector)
+        {
+            for (const Variant& v : variant.toVector())
+                prepare(v);
+        }
+        else if (variant.type() == Type::Map)
+        {
+            prepareNode(variant.toMap());
+            for (const auto& it : variant.toMap())
+                prepare(it.second);
+        }
+    }
+
+    JSON_VARIANT_INLINE void PreparedSchema::prepareNode(const VariantMap& schemaVariantMap)
+    {
+        Node node;
+        bool used = false;
+        auto it = schemaVariantMap.find("pattern");
+        if (it != schemaVariantMap.end() && it->second.type() == Type::String)
+        {
+            used = true;
+            try
+            {
+                node.pattern.emplace(it->second.toString());
+            }
+            catch (const std::regex_error&)
+            {
+                node.invalidPattern = true;
+            }
+        }
+
+        it = schemaVariantMap.find("patternProperties");
+        if (it != schemaVariantMap.end() && it->second.type() == Type::Map)
+        {
+            used = true;
+            for (const auto& patternIt : it->second.toMap())
+            {
+                try
+                {
+                    if (patternIt.second.type() != Type::Map)
+                        node.invalidPatternProperties = true;
+                    else
+                        node.patternProperties.emplace_back(std::regex(patternIt.first.str()), &patternIt.second);
+                }
+                catch (const std::regex_error&)
+                {
+                    node.invalidPatternProperties = true;
+                }
+            }
+        }
+
+        it = schemaVariantMap.find("enum");
+        if (it != schemaVariantMap.end() && it->second.type() == Type::Vector && it->second.toVector().size() >= hashedEnumThreshold)
+        {
+            used = true;
+            for (const Variant& v : it->second.toVector())
+                node.enumValues.insert(&v);
+        }
+
+        it = schemaVariantMap.find("anyOf");
+        if (it != schemaVariantMap.end() && it->second.type() == Type::Vector)
+        {
+            used = true;
+            node.anyOf = orderedBranches(it->second.toVector());
+        }
+
+        it = schemaVariantMap.find("oneOf");
+        if (it != schemaVariantMap.end() && it->second.type() == Type::Vector)
+        {
+            used = true;
+            node.oneOf = orderedBranches(it->second.toVector());
+        }
+
+        it = schemaVariantMap.find("format");
+        if (it != schemaVariantMap.end() && it->second.type() == Type::String)
+        {
+            node.format = FormatValidator::fromName(it->second.toString());
+            used = used || node.format != nullptr;
+        }
+
+        if (used)
+            nodes_.emplace(&schemaVariantMap, std::move(node));
+    }
+
+    JSON_VARIANT_INLINE size_t PreparedSchema::cost(const Variant& variant)
+    {
+        size_t nodes = 1;
+        if (variant.type() == Type::Vector)
+        {
+            for (const Variant& v : variant.toVector())
+                nodes += cost(v);
+        }
+        else if (variant.type() == Type::Map)
+        {
+            for (const auto& it : variant.toMap())
+                nodes += cost(it.second);
+        }
+
+        return nodes;
+    }
+
+    JSON_VARIANT_INLINE std::vector<const VariantMap*> PreparedSchema::orderedBranches(const VariantVector& branches)
+    {
+        // the size of the branch schema is a good enough estimate of how expensive it is to check it
+        std::vector<std::pair<size_t, const VariantMap*>> costBranches;
+        for (const Variant& v : branches)
+        {
+            if (v.type() == Type::Map)
+                costBranches.emplace_back(cost(v), &v.toMap());
+        }
+
+        std::stable_sort(costBranches.begin(), costBranches.end(), [](const auto& l, const auto& r) { return l.first < r.first; });
+        std::vector<const VariantMap*> orderedBranches;
+        for (const auto& costBranch : costBranches)
+            orderedBranches.push_back(costBranch.second);
+
+        return orderedBranches;
+    }
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+    JSON_VARIANT_INLINE PreparedSchemaCache& PreparedSchemaCache::instance()
+    {
+        static PreparedSchemaCache cache;
+        return cache;
+    }
+
+    JSON_VARIANT_INLINE uint64_t PreparedSchemaCache::hashText(std::string_view text)
+    {
+        // reads 8 bytes per step, final mixing from murmur3
+        const uint64_t multiplier = 0x9fb21c651e98df25ULL;
+        uint64_t hash = 0x9e3779b97f4a7c15ULL ^ (text.size() * multiplier);
+        size_t pos = 0;
+        for (; pos + 8 <= text.size(); pos += 8)
+        {
+            uint64_t block;
+            std::memcpy(&block, text.data() + pos, 8);
+            block *= multiplier;
+            block ^= block >> 29;
+            hash = (hash ^ block) * multiplier;
+        }
+
+        uint64_t tail = 0;
+        for (size_t i = 0; pos + i < text.size(); i++)
+            tail |= (uint64_t)(unsigned char)text[pos + i] << (8 * i);
+
+        hash = (hash ^ tail) * multiplier;
+        hash ^= hash >> 33;
+        hash *= 0xff51afd7ed558ccdULL;
+        hash ^= hash >> 33;
+        hash *= 0xc4ceb9fe1a85ec53ULL;
+        hash ^= hash >> 33;
+        return hash;
+    }
+
+    JSON_VARIANT_INLINE std::shared_ptr<const PreparedSchema> PreparedSchemaCache::get(const std::string& schemaText, ParseResult& result)
+    {
+        const uint64_t hash = hashText(schemaText);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            const auto it = index_.find(hash);
+            if (it != index_.end() && it->second->schemaText == schemaText)
+            {
+                ++hits_;
+                entries_.splice(entries_.begin(), entries_, it->second);
+                return it->second->preparedSchema;
+            }
+
+            ++misses_;
+        }
+
+        // parsing and preparing runs unlocked, two threads missing the same schema both prepare it and the later one wins
+        Variant schemaVariant;
+        ParseContext context((ParseOptions()));
+        result = JsonParser::parse(schemaText, schemaVariant, context);
+        if (!result)
+            return nullptr;
+
+        auto preparedSchema = std::make_shared<const PreparedSchema>(std::move(schemaVariant));
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (capacity_ == 0)
+            return preparedSchema;
+
+        const auto it = index_.find(hash);
+        if (it != index_.end())
+        {
+            entries_.erase(it->second);
+            index_.erase(it);
+        }
+
+        entries_.push_front(Entry{ hash, schemaText, preparedSchema });
+        index_.emplace(hash, entries_.begin());
+        evict();
+        return preparedSchema;
+    }
+
+    JSON_VARIANT_INLINE void PreparedSchemaCache::evict()
+    {
+        while (entries_.size() > capacity_)
+        {
+            index_.erase(entries_.back().hash);
+            entries_.pop_back();
+            ++evictions_;
+        }
+    }
+
+    JSON_VARIANT_INLINE void PreparedSchemaCache::setCapacity(size_t capacity)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        capacity_ = capacity;
+        evict();
+    }
+
+    JSON_VARIANT_INLINE size_t PreparedSchemaCache::capacity()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return capacity_;
+    }
+
+    JSON_VARIANT_INLINE SchemaCacheStats PreparedSchemaCache::stats()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return SchemaCacheStats{ hits_, misses_, evictions_, entries_.size(), capacity_ };
+    }
+
+    JSON_VARIANT_INLINE void PreparedSchemaCache::clear()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        entries_.clear();
+        index_.clear();
+        hits_ = misses_ = evictions_ = 0;
+    }
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+    JSON_VARIANT_INLINE SchemaValidator::SchemaValidator(const PreparedSchema& preparedSchema, ValidationResult* pResult)
+        : preparedSchema_(preparedSchema),
+          wholeSchemaVariantMap_(preparedSchema.schema().toMap()),
+          pResult_(pResult),
+          failures_(0)
+    {
+    }
+
+    JSON_VARIANT_INLINE bool SchemaValidator::validate(const Variant& schemaVariant, const Variant& jsonVariant, ValidationResult& result)
+    {
+        return validate(PreparedSchema(schemaVariant), jsonVariant, result);
+    }
+
+    JSON_VARIANT_INLINE bool SchemaValidator::validate(const PreparedSchema& preparedSchema, const Variant& jsonVariant, ValidationResult& result)
+    {
+        result.clear();
+        if (preparedSchema.schema().type() != Type::Map)
+        {
+            result.add(ValidationErrorCode::InvalidSchema, "", "Bad schema type", "");
+            return false;
+        }
+
+        OperationScope scope(Operation::Validate);
+        SchemaValidator validator(preparedSchema, &result);
+        validator.compare(validator.wholeSchemaVariantMap_, jsonVariant);
+        scope.finish(result.isValid(), 0, &jsonVariant);
+        return result.isValid();
+    }
+
+    JSON_VARIANT_INLINE bool SchemaValidator::collectAll() const
+    {
+        return pResult_ != nullptr && pResult_->collectAll();
+    }
+
+    JSON_VARIANT_INLINE bool SchemaValidator::report(ValidationErrorCode code, const char* keyword, const char* message)
+    {
+        // without collecting only the first error is kept, returns whether validation should go on
+        ++failures_;
+        if (pResult_ == nullptr)
+            return false;
+
+        if (pResult_->collectAll() || pResult_->isValid())
+            pResult_->add(code, keyword, message, path_);
+
+        return pResult_->collectAll();
+    }
+
+    JSON_VARIANT_INLINE bool SchemaValidator::schemaError(const char* keyword, const char* message)
+    {
+        report(ValidationErrorCode::InvalidSchema, keyword, message);
+        return false;
+    }
+
+    JSON_VARIANT_INLINE bool SchemaValidator::probe(const VariantMap& schemaVariantMap, const Variant& jsonVariant)
+    {
+        // checks whether a combinator branch matches, nothing is recorded and the first failure stops it
+        SchemaValidator validator(preparedSchema_, nullptr);
+        return validator.compare(schemaVariantMap, jsonVariant);
+    }
+
+    JSON_VARIANT_INLINE const Variant* SchemaValidator::valueFromMap(const VariantMap& schemaVariantMap, const char* key, Type type)
+    {
+        const auto it = schemaVariantMap.find(key);
+        if (it == schemaVariantMap.end())
+            return nullptr;
+
+        if (it->second.type() != type)
+        {
+            schemaError(key, "Unexpected value type for keyword in schema");
+            return nullptr;
+        }
+
+        return &it->second;
+    }
+
+    JSON_VARIANT_INLINE std::vector<std::string> SchemaValidator::tokenize(const std::string& str, char delim)
+    {
+        std::vector<std::string> outVector;
+        size_t start;
+        size_t end = 0;
+
+        while ((start = str.find_first_not_of(delim, end)) != std::string::npos)
+        {
+            end = str.find(delim, start);
+            std::string pathStr = str.substr(start, end - start);
+            if (pathStr != "#")
+                outVector.push_back(pathStr);
+        }
+
+        return outVector;
+    }
+
+    JSON_VARIANT_INLINE const VariantMap* SchemaValidator::fromRef(const std::string& refPath)
+    {
+        std::vector<std::string> pathVector = tokenize(refPath, '/');
+        const VariantMap* pVariantMap = &wholeSchemaVariantMap_;
+        for (const std::string& s : pathVector)
+        {
+            const auto it = pVariantMap->find(s);
+            if (it == pVariantMap->end())
+            {
+                schemaError("$ref", "Unable find ref according path");
+                return nullptr;
+            }
+
+            if (it->second.type() != Type::Map)
+            {
+                schemaError("$ref", "Ref link is not valid");
+                return nullptr;
+            }
+
+            pVariantMap = &it->second.toMap();
+        }
+
+        return pVariantMap;
+    }
+
+    JSON_VARIANT_INLINE void SchemaValidator::appendPath(std::string_view key)
+    {
+        // json pointer token, '~' and '/' have to be escaped
+        path_.push_back('/');
+        for (char c : key)
+        {
+            if (c == '~')
+                path_.append("~0");
+            else if (c == '/')
+                path_.append("~1");
+            else
+                path_.push_back(c);
+        }
+    }
+
+    JSON_VARIANT_INLINE bool SchemaValidator::compareAt(const VariantMap& schemaVariantMap, const Variant& jsonVariant, std::string_view key)
+    {
+        const size_t pathSize = path_.size();
+        appendPath(key);
+        bool valid = compare(schemaVariantMap, jsonVariant);
+        path_.resize(pathSize);
+        return valid;
+    }
+
+    JSON_VARIANT_INLINE bool SchemaValidator::compareAt(const VariantMap& schemaVariantMap, const Variant& jsonVariant, size_t index)
+    {
+        char buffer[24];
+        const size_t pathSize = path_.size();
+        path_.push_back('/');
+        path_.append(buffer, std::to_chars(buffer, buffer + sizeof(buffer), index).ptr);
+        bool valid = compare(schemaVariantMap, jsonVariant);
+        path_.resize(pathSize);
+        return valid;
+    }
+
+    JSON_VARIANT_INLINE bool SchemaValidator::compare(const VariantMap& schemaVariantMap, const Variant& jsonVariant)
+    {
+        // cheap keywords go first so that a failing value is rejected before the nested schemas are walked
+        const size_t failures = failures_;
+        const auto refIt = schemaVariantMap.find("$ref");
+        if (refIt != schemaVariantMap.end())
+        {
+            if (refIt->second.type() != Type::String)
+                return schemaError("$ref", "Expected string for $ref in schema");
+
+            const VariantMap* pRefVariantMap = fromRef(refIt->second.toString());
+            if (pRefVariantMap == nullptr || (!compare(*pRefVariantMap, jsonVariant) && !collectAll()))
+                return false;
+        }
+
+        const auto typeIt = schemaVariantMap.find("type");
+        if (typeIt != schemaVariantMap.end() && !checkType(typeIt->second, jsonVariant))
+            return false;
+
+        const PreparedSchema::Node* pNode = preparedSchema_.node(schemaVariantMap);
+        if (!compareEnum(schemaVariantMap, jsonVariant, pNode) && !collectAll())
+            return false;
+
+        bool valid = true;
+        switch (jsonVariant.type())
+        {
+        case Type::Map:
+        case Type::Record:
+            valid = compareMap(schemaVariantMap, jsonVariant, pNode);
+            break;
+
+        case Type::Vector:
+        case Type::NumberArray:
+            valid = compareVector(schemaVariantMap, jsonVariant);
+            break;
+
+        case Type::String:
+            valid = compareString(schemaVariantMap, jsonVariant, pNode);
+            break;
+
+        case Type::Number:
+            valid = compareNumber(schemaVariantMap, jsonVariant);
+            break;
+
+        default:
+            break;
+        }
+
+        if (!valid && !collectAll())
+            return false;
+
+        compareCombinators(schemaVariantMap, jsonVariant, pNode);
+        return failures_ == failures;
+    }
+
+    JSON_VARIANT_INLINE bool SchemaValidator::typeMatches(const std::string& typeStr, const Variant& jsonVariant)
+    {
+        switch (jsonVariant.type())
+        {
+        case Type::Map:
+        case Type::Record:
+            return typeStr == "object";
+
+        case Type::Vector:
+        case Type::NumberArray:
+            return typeStr == "array";
+
+        case Type::String:
+            return typeStr == "string";
+
+        case Type::Number:
+            return typeStr == "number" || (typeStr == "integer" && jsonVariant.isInteger());
+
+        case Type::Bool:
+            return typeStr == "boolean";
+
+        case Type::Null:
+            return typeStr == "null";
+
+        default:
+            return false;
+        }
+    }
+
+    JSON_VARIANT_INLINE bool SchemaValidator::checkType(const Variant& typeVariant, const Variant& jsonVariant)
+    {
+        static const std::pair<const char*, const char*> typeMessages[] =
+        {
+            { "object", "Map required" },
+            { "array", "Expected vector for items" },
+            { "integer", "Expected integer value" },
+            { "number", "Expected numeric value" },
+            { "null", "Expected null value" },
+            { "boolean", "Expected boolean value" },
+            { "string", "Expected string value" }
+        };
+
+        if (typeVariant.type() == Type::String)
+        {
+            const std::string& typeStr = typeVariant.toString();
+            for (const auto& typeMessage : typeMessages)
+            {
+                if (typeStr != typeMessage.first)
+                    continue;
+
+                if (typeMatches(typeStr, jsonVariant))
+                    return true;
+
+                report(ValidationErrorCode::Type, "type", typeMessage.second);
+                return false;
+            }
+
+            return schemaError("type", "Unsupported type in json schema");
+        }
+
+        if (typeVariant.type() != Type::Vector)
+            return schemaError("type", "Expected string or vector for type in schema");
+
+        for (const Variant& v : typeVariant.toVector())
+        {
+            if (v.type() != Type::String)
+                return schemaError("type", "Expected string in type vector");
+
+            if (typeMatches(v.toString(), jsonVariant))
+                return true;
+        }
+
+        report(ValidationErrorCode::Type, "type", "Value doesn't match any of the types");
+        return false;
+    }
+
+    JSON_VARIANT_INLINE bool SchemaValidator::compareEnum(const VariantMap& schemaVariantMap, const Variant& jsonVariant, const PreparedSchema::Node* pNode)
+    {
+        const size_t failures = failures_;
+        const Variant* pEnum = valueFromMap(schemaVariantMap, "enum", Type::Vector);
+        if (pEnum)
+        {
+            bool found;
+            if (pNode && !pNode->enumValues.empty())
+            {
+                found = pNode->enumValues.find(&jsonVariant) != pNode->enumValues.end();
+            }
+            else
+            {
+                const VariantVector& enumVector = pEnum->toVector();
+                found = std::find(enumVector.begin(), enumVector.end(), jsonVariant) != enumVector.end();
+            }
+
+            if (!found && !report(ValidationErrorCode::Enum, "enum", "Value is not one of the enum values"))
+                return false;
+        }
+
+        const auto constIt = schemaVariantMap.find("const");
+        if (constIt != schemaVariantMap.end() && !(constIt->second == jsonVariant))
+        {
+            report(ValidationErrorCode::Const, "const", "Value is not equal to the const value");
+            return false;
+        }
+
+        return failures_ == failures;
+    }
+
+    JSON_VARIANT_INLINE bool SchemaValidator::compareCombinators(const VariantMap& schemaVariantMap, const Variant& jsonVariant, const PreparedSchema::Node* pNode)
+    {
+        const size_t failures = failures_;
+        const Variant* pAllOf = valueFromMap(schemaVariantMap, "allOf", Type::Vector);
+        if (pAllOf)
+        {
+            for (const Variant& v : pAllOf->toVector())
+            {
+                if (v.type() != Type::Map)
+                    return schemaError("allOf", "Expected map in allOf vector");
+
+                if (!compare(v.toMap(), jsonVariant) && !collectAll())
+                    return false;
+            }
+        }
+
+        if (valueFromMap(schemaVariantMap, "anyOf", Type::Vector))
+        {
+            // branches are ordered from the cheapest one and the first match ends it
+            bool matched = false;
+            for (const VariantMap* pBranch : pNode->anyOf)
+            {
+                if (probe(*pBranch, jsonVariant))
+                {
+                    matched = true;
+                    break;
+                }
+            }
+
+            if (!matched && !report(ValidationErrorCode::AnyOf, "anyOf", "Value doesn't match any schema in anyOf"))
+                return false;
+        }
+
+        if (valueFromMap(schemaVariantMap, "oneOf", Type::Vector))
+        {
+            // the second match already decides the result
+            size_t matches = 0;
+            for (const VariantMap* pBranch : pNode->oneOf)
+            {
+                if (probe(*pBranch, jsonVariant) && ++matches > 1)
+                    break;
+            }
+
+            if (matches == 0 && !report(ValidationErrorCode::OneOf, "oneOf", "Value doesn't match any schema in oneOf"))
+                return false;
+
+            if (matches > 1 && !report(ValidationErrorCode::OneOf, "oneOf", "Value matches more than one schema in oneOf"))
+                return false;
+        }
+
+        const Variant* pNot = valueFromMap(schemaVariantMap, "not", Type::Map);
+        if (pNot && probe(pNot->toMap(), jsonVariant))
+            report(ValidationErrorCode::Not, "not", "Value matches the schema in not");
+
+        return failures_ == failures;
+    }
+
+    JSON_VARIANT_INLINE bool SchemaValidator::compareMap(const VariantMap& schemaVariantMap, const Variant& jsonVariant, const PreparedSchema::Node* pNode)
+    {
+        // records are walked in place, keys are looked up through Variant::find in maps and records alike
+        const size_t failures = failures_;
+        const bool isRecord = (jsonVariant.type() == Type::Record);
+        const size_t propertyCount = isRecord ? jsonVariant.shape().size() : jsonVariant.toMap().size();
+        auto contains = [&jsonVariant](const std::string& key) { return jsonVariant.find(key) != nullptr; };
+        const Variant* pRequiredVariant = valueFromMap(schemaVariantMap, "required", Type::Vector);
+        if (pRequiredVariant)
+        {
+            for (const auto& v : pRequiredVariant->toVector())
+            {
+                if (v.type() != Type::String)
+                {
+                    schemaError("required", "Expected string in required vector");
+                    continue;
+                }
+
+                if (!contains(v.toString()))
+                {
+                    const size_t pathSize = path_.size();
+                    appendPath(v.toString());
+                    bool proceed = report(ValidationErrorCode::Required, "required", "Missing key in map");
+                    path_.resize(pathSize);
+                    if (!proceed)
+                        return false;
+                }
+            }
+        }
+
+        const Variant* pMinProperties = valueFromMap(schemaVariantMap, "minProperties", Type::Number);
+        if (pMinProperties && pMinProperties->toNumber() > (double)propertyCount && !report(ValidationErrorCode::MinProperties, "minProperties", "Size of map is smaller as defined in minProperties"))
+            return false;
+
+        const Variant* pMaxProperties = valueFromMap(schemaVariantMap, "maxProperties", Type::Number);
+        if (pMaxProperties && pMaxProperties->toNumber() < (double)propertyCount && !report(ValidationErrorCode::MaxProperties, "maxProperties", "Size of map is greater as defined in maxProperties"))
+            return false;
+
+        const Variant* pDependentRequired = valueFromMap(schemaVariantMap, "dependentRequired", Type::Map);
+        if (pDependentRequired)
+        {
+            for (const auto& it : pDependentRequired->toMap())
+            {
+                if (it.second.type() != Type::Vector)
+                    return schemaError("dependentRequired", "Expected vector in dependentRequired");
+
+                if (!contains(it.first.str()))
+                    continue;
+
+                for (const Variant& v : it.second.toVector())
+                {
+                    if (v.type() != Type::String)
+                        return schemaError("dependentRequired", "Expected string in dependentRequired vector");
+
+                    if (!contains(v.toString()) && !report(ValidationErrorCode::DependentRequired, "dependentRequired", "Missing key required by other key in map"))
+                        return false;
+                }
+            }
+        }
+
+        const VariantMap* pPropertiesVariantMap = nullptr;
+        const Variant* pPropertiesVariant = valueFromMap(schemaVariantMap, "properties", Type::Map);
+        if (pPropertiesVariant)
+        {
+            pPropertiesVariantMap = &pPropertiesVariant->toMap();
+            for (const auto& it : *pPropertiesVariantMap)
+            {
+                if (it.second.type() != Type::Map)
+                {
+                    schemaError("properties", "Missing map for key");
+                    continue;
+                }
+
+                const Variant* pValue = jsonVariant.find(it.first.str());
+                if (pValue && !compareAt(it.second.toMap(), *pValue, it.first) && !collectAll())
+                    return false;
+            }
+        }
+
+        if (pNode && pNode->invalidPatternProperties)
+            return schemaError("patternProperties", "Expected map with valid regular expressions for patternProperties");
+
+        const auto additionalIt = schemaVariantMap.find("additionalProperties");
+        const Variant* pAdditional = (additionalIt == schemaVariantMap.end()) ? nullptr : &additionalIt->second;
+        if (pAdditional && pAdditional->type() != Type::Bool && pAdditional->type() != Type::Map)
+            return schemaError("additionalProperties", "Expected boolean or map for additionalProperties");
+
+        if ((pNode && !pNode->patternProperties.empty()) || pAdditional)
+        {
+            // false stops the walk
+            auto compareProperty = [&](const Key& key, const Variant& value)
+            {
+                bool matched = pPropertiesVariantMap && pPropertiesVariantMap->contains(key.c_str());
+                if (pNode)
+                {
+                    for (const auto& patternProperty : pNode->patternProperties)
+                    {
+                        if (!std::regex_search(key.str(), patternProperty.first))
+                            continue;
+
+                        matched = true;
+                        if (!compareAt(patternProperty.second->toMap(), value, key) && !collectAll())
+                            return false;
+                    }
+                }
+
+                if (matched || !pAdditional)
+                    return true;
+
+                if (pAdditional->type() == Type::Map)
+                    return compareAt(pAdditional->toMap(), value, key) || collectAll();
+
+                if (pAdditional->toBool())
+                    return true;
+
+                const size_t pathSize = path_.size();
+                appendPath(key);
+                bool proceed = report(ValidationErrorCode::AdditionalProperties, "additionalProperties", "Key is not allowed in map");
+                path_.resize(pathSize);
+                return proceed;
+            };
+
+            if (isRecord)
+            {
+                std::span<const Variant> values = jsonVariant.recordValues();
+                for (size_t i = 0; i < values.size(); i++)
+                {
+                    if (!compareProperty(jsonVariant.shape().key(i), values[i]))
+                        return false;
+                }
+            }
+            else
+            {
+                for (const auto& it : jsonVariant.toMap())
+                {
+                    if (!compareProperty(it.first, it.second))
+                        return false;
+                }
+            }
+        }
+
+        return failures_ == failures;
+    }
+
+    JSON_VARIANT_INLINE bool SchemaValidator::compareVector(const VariantMap& schemaVariantMap, const Variant& jsonVariant)
+    {
+        // typed arrays are walked in place, each number is validated as the plain number variant it stands for
+        const size_t failures = failures_;
+        const VariantVector* pVariantVector = (jsonVariant.type() == Type::Vector) ? &jsonVariant.toVector() : nullptr;
+        const bool doubles = !pVariantVector && jsonVariant.numberType() == NumberType::Double;
+        const size_t size = pVariantVector ? pVariantVector->size() : doubles ? jsonVariant.toDoubleArray().size() : jsonVariant.toInt64Array().size();
+        auto compareItem = [&](const VariantMap& itemSchemaVariantMap, size_t i)
+        {
+            if (pVariantVector)
+                return compareAt(itemSchemaVariantMap, (*pVariantVector)[i], i);
+
+            return compareAt(itemSchemaVariantMap, doubles ? Variant(jsonVariant.toDoubleArray()[i]) : Variant((long long)jsonVariant.toInt64Array()[i]), i);
+        };
+
+        const VariantMap* pSchemaVariantMap = nullptr;
+        const VariantVector* pSchemaVariantVector = nullptr;
+        const auto it = schemaVariantMap.find("items");
+        if (it == schemaVariantMap.end())
+        {
+            // without items every item is valid
+        }
+        else if (it->second.type() == Type::Map)
+        {
+            pSchemaVariantMap = &it->second.toMap();
+        }
+        else if (it->second.type() == Type::Vector)
+        {
+            const auto& schemaVariantVector = it->second.toVector();
+            if (schemaVariantVector.empty())
+                return schemaError("items", "Expected non empty schema vector");
+
+            if (schemaVariantVector.size() == 1)
+            {
+                const auto& schVariant = schemaVariantVector[0];
+                if (schVariant.type() != Type::Map)
+                    return schemaError("items", "Expected map for items vector in schema");
+
+                pSchemaVariantMap = &schVariant.toMap();
+            }
+            else
+            {
+                pSchemaVariantVector = &schemaVariantVector;
+            }
+        }
+        else
+        {
+            return schemaError("items", "Expected map or vector for items in schema");
+        }
+
+        const Variant* pMinItems = valueFromMap(schemaVariantMap, "minItems", Type::Number);
+        if (pMinItems && pMinItems->toNumber() > (double)size && !report(ValidationErrorCode::MinItems, "minItems", "Too short vector"))
+            return false;
+
+        const Variant* pMaxItems = valueFromMap(schemaVariantMap, "maxItems", Type::Number);
+        if (pMaxItems && pMaxItems->toNumber() < (double)size && !report(ValidationErrorCode::MaxItems, "maxItems", "Too long vector"))
+            return false;
+
+        const Variant* pMinContains = valueFromMap(schemaVariantMap, "minContains", Type::Number);
+        if (pMinContains && pMinContains->toNumber() > (double)size && !report(ValidationErrorCode::MinContains, "minContains", "Too short vector"))
+            return false;
+
+        const Variant* pMaxContains = valueFromMap(schemaVariantMap, "maxContains", Type::Number);
+        if (pMaxContains && pMaxContains->toNumber() < (double)size && !report(ValidationErrorCode::MaxContains, "maxContains", "Too long vector"))
+            return false;
+
+        if (pSchemaVariantMap != nullptr)
+        {
+            if (pVariantVector && size >= parallelItemsThreshold && pResult_ != nullptr && !insideParallelJob && WorkerPool::instance().size() > 0)
+            {
+                if (!compareItemsParallel(*pSchemaVariantMap, *pVariantVector) && !collectAll())
+                    return false;
+            }
+            else
+            {
+                for (size_t i = 0; i < size; i++)
+                {
+                    if (!compareItem(*pSchemaVariantMap, i) && !collectAll())
+                        return false;
+                }
+            }
+        }
+        else if (pSchemaVariantVector != nullptr)
+        {
+            if (size != pSchemaVariantVector->size())
+            {
+                if (!report(ValidationErrorCode::Items, "items", "Different size for heterogenous schema vector and checked vector"))
+                    return false;
+            }
+            else
+            {
+                for (size_t i = 0; i < size; i++)
+                {
+                    const auto& schVariant = pSchemaVariantVector->at(i);
+                    if (schVariant.type() != Type::Map)
+                        return schemaError("items", "Expected map in json schema vector");
+
+                    if (!compareItem(schVariant.toMap(), i) && !collectAll())
+                        return false;
+                }
+            }
+        }
+
+        const Variant* pUniqueItems = valueFromMap(schemaVariantMap, "uniqueItems", Type::Bool);
+        if (pUniqueItems && pUniqueItems->toBool())
+        {
+            bool unique = true;
+            if (pVariantVector)
+            {
+                std::unordered_set<const Variant*, VariantHash, VariantEqual> uniqueItems;
+                for (const Variant& v : *pVariantVector)
+                    unique = unique && uniqueItems.insert(&v).second;
+            }
+            else
+            {
+                // numbers of one typed array share their type, they are compared as they are stored
+                auto uniqueNumbers = [](auto numbers)
+                {
+                    std::unordered_set<typename decltype(numbers)::value_type> uniqueItems(numbers.begin(), numbers.end());
+                    return uniqueItems.size() == numbers.size();
+                };
+
+                unique = doubles ? uniqueNumbers(jsonVariant.toDoubleArray()) : uniqueNumbers(jsonVariant.toInt64Array());
+            }
+
+            if (!unique)
+            {
+                report(ValidationErrorCode::UniqueItems, "uniqueItems", "Some items in vector are not unique");
+                return false;
+            }
+        }
+
+        return failures_ == failures;
+    }
+
+    JSON_VARIANT_INLINE bool SchemaValidator::compareItemsParallel(const VariantMap& itemSchemaVariantMap, const VariantVector& variantVector)
+    {
+        // every chunk is validated into its own result, chunks are handed out in increasing order and every item below
+        // the lowest known failure is still checked, so the outcome is the same as with serial validation
+        const size_t size = variantVector.size();
+        const size_t chunks = (size + parallelChunkSize - 1) / parallelChunkSize;
+        const bool collectAll = pResult_->collectAll();
+        std::vector<ValidationResult> chunkResults(chunks, ValidationResult(collectAll));
+        std::atomic<size_t> nextChunk(0);
+        std::atomic<size_t> firstFailure(size);
+
+        auto body = [&]()
+        {
+            for (;;)
+            {
+                size_t chunk = nextChunk.fetch_add(1);
+                size_t begin = chunk * parallelChunkSize;
+                if (chunk >= chunks || (!collectAll && begin >= firstFailure.load()))
+                    return;
+
+                SchemaValidator validator(preparedSchema_, &chunkResults[chunk]);
+                validator.path_ = path_;
+                size_t end = std::min(begin + parallelChunkSize, size);
+                for (size_t i = begin; i < end; i++)
+                {
+                    if (!collectAll && i >= firstFailure.load())
+                        break;
+
+                    if (!validator.compareAt(itemSchemaVariantMap, variantVector[i], i) && !collectAll)
+                    {
+                        size_t expected = firstFailure.load();
+                        while (i < expected && !firstFailure.compare_exchange_weak(expected, i))
+                        {
+                        }
+
+                        break;
+                    }
+                }
+            }
+        };
+
+        WorkerPool::instance().run(body, std::min(WorkerPool::instance().size(), chunks - 1));
+        if (!collectAll)
+        {
+            if (firstFailure.load() == size)
+                return true;
+
+            ++failures_;
+            pResult_->append(chunkResults[firstFailure.load() / parallelChunkSize]);
+            return false;
+        }
+
+        bool valid = true;
+        for (const ValidationResult& chunkResult : chunkResults)
+        {
+            valid = valid && chunkResult.isValid();
+            failures_ += chunkResult.size();
+            pResult_->append(chunkResult);
+        }
+
+        return valid;
+    }
+
+    JSON_VARIANT_INLINE bool SchemaValidator::compareString(const VariantMap& schemaVariantMap, const Variant& jsonVariant, const PreparedSchema::Node* pNode)
+    {
+        const size_t failures = failures_;
+        const std::string& value = jsonVariant.toString();
+        const Variant* pMinLength = valueFromMap(schemaVariantMap, "minLength", Type::Number);
+        if (pMinLength && pMinLength->toNumber() > (double)value.size() && !report(ValidationErrorCode::MinLength, "minLength", "Too short string"))
+            return false;
+
+        const Variant* pMaxLength = valueFromMap(schemaVariantMap, "maxLength", Type::Number);
+        if (pMaxLength && pMaxLength->toNumber() < (double)value.size() && !report(ValidationErrorCode::MaxLength, "maxLength", "Too long string"))
+            return false;
+
+        if (valueFromMap(schemaVariantMap, "pattern", Type::String))
+        {
+            if (pNode->invalidPattern)
+                return schemaError("pattern", "Invalid regular expression in pattern");
+
+            if (!std::regex_match(value, *pNode->pattern) && !report(ValidationErrorCode::Pattern, "pattern", "String doesn't match the pattern"))
+                return false;
+        }
+
+        // unknown formats are only annotations and are not checked
+        if (pNode && pNode->format && !pNode->format(value) && !report(ValidationErrorCode::Format, "format", "String doesn't match the format"))
+            return false;
+
+        return failures_ == failures;
+    }
+
+    JSON_VARIANT_INLINE bool SchemaValidator::compareNumber(const VariantMap& schemaVariantMap, const Variant& jsonVariant)
+    {
+        const size_t failures = failures_;
+        double value = jsonVariant.toNumber();
+        const Variant* pMinimum = valueFromMap(schemaVariantMap, "minimum", Type::Number);
+        if (pMinimum && pMinimum->toNumber() > value && !report(ValidationErrorCode::Minimum, "minimum", "Numeric value is smaller than minimum"))
+            return false;
+
+        const Variant* pMaximum = valueFromMap(schemaVariantMap, "maximum", Type::Number);
+        if (pMaximum && pMaximum->toNumber() < value && !report(ValidationErrorCode::Maximum, "maximum", "Numeric value is greater than maximum"))
+            return false;
+
+        const Variant* pExclusiveMinimum = valueFromMap(schemaVariantMap, "exclusiveMinimum", Type::Number);
+        if (pExclusiveMinimum && pExclusiveMinimum->toNumber() >= value && !report(ValidationErrorCode::ExclusiveMinimum, "exclusiveMinimum", "Numeric value is smaller than exclusive minimum"))
+            return false;
+
+        const Variant* pExclusiveMaximum = valueFromMap(schemaVariantMap, "exclusiveMaximum", Type::Number);
+        if (pExclusiveMaximum && pExclusiveMaximum->toNumber() <= value && !report(ValidationErrorCode::ExclusiveMaximum, "exclusiveMaximum", "Numeric value is greater than exclusive maximum"))
+            return false;
+
+        const Variant* pMultipleOf = valueFromMap(schemaVariantMap, "multipleOf", Type::Number);
+        if (pMultipleOf)
+        {
+            double multipleOf = pMultipleOf->toNumber();
+            if (!isInteger(multipleOf) || multipleOf <= 0)
+                return schemaError("multipleOf", "Multiple of has to be an positive number");
+
+            // integers are checked exactly, only doubles go through the division
+            bool multiple;
+            if (jsonVariant.numberType() == NumberType::Int64 && pMultipleOf->numberType() == NumberType::Int64)
+                multiple = jsonVariant.toInt64() % pMultipleOf->toInt64() == 0;
+            else if (jsonVariant.numberType() == NumberType::UInt64 && pMultipleOf->numberType() == NumberType::Int64)
+                multiple = jsonVariant.toUInt64() % pMultipleOf->toUInt64() == 0;
+            else
+                multiple = isInteger(value / multipleOf);
+
+            if (!multiple && !report(ValidationErrorCode::MultipleOf, "multipleOf", "Multiple of division must be an integer"))
+                return false;
+        }
+
+        return failures_ == failures;
+    }
+
+#ifndef _WIN32
+    // a task destroyed while suspended here destroys the awaiter with its frame, the scheduler forgets the handle then
+    struct ReadableAwaiter
+    {
+        IoScheduler& scheduler;
+        int fd;
+        bool waiting = false;
+        bool suspended = false;
+
+        ReadableAwaiter(IoScheduler& scheduler, int fd) : scheduler(scheduler), fd(fd) {}
+        ReadableAwaiter(const ReadableAwaiter&) = delete;
+        ReadableAwaiter& operator=(const ReadableAwaiter&) = delete;
+        ~ReadableAwaiter()
+        {
+            if (suspended)
+                scheduler.cancel(fd);
+        }
+
+        bool await_ready() const { return false; }
+        bool await_suspend(std::coroutine_handle<> handle) { waiting = suspended = scheduler.waitReadable(fd, handle); return waiting; }
+        bool await_resume() { suspended = false; return waiting; }
+    };
+
+    JSON_VARIANT_INLINE ParseResult failed(ParseErrorCode code)
+    {
+        ParseResult result;
+        result.code = code;
+        return result;
+    }
+#endif
+
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace JsonSerialization
+{
+    JSON_VARIANT_INLINE bool Variant::fromJson(const std::string& jsonStr, Variant& jsonVariant, std::string* errorStr /*= nullptr*/)
+    {
+        return fromJson(jsonStr, jsonVariant, ParseOptions(), errorStr);
+    }
+
+    JSON_VARIANT_INLINE bool Variant::fromJson(const std::string& jsonStr, Variant& jsonVariant, const ParseOptions& options, std::string* errorStr /*= nullptr*/)
+    {
+        ParseResult result = parse(jsonStr, jsonVariant, options);
+        if (!result && errorStr)
+            *errorStr = result.toString();
+
+        return bool(result);
+    }
+
+    JSON_VARIANT_INLINE ParseResult Variant::parse(std::string_view jsonStr, Variant& jsonVariant, const ParseOptions& options /*= ParseOptions()*/) noexcept
+    {
+        try
+        {
+            JsonSerializationInternal::ParseContext context(options);
+            return JsonSerializationInternal::JsonParser::parse(jsonStr, jsonVariant, context);
+        }
+        catch (const std::bad_alloc&)
+        {
+            ParseResult result;
+            result.code = ParseErrorCode::OutOfMemory;
+            return result;
+        }
+    }
+
+    JSON_VARIANT_INLINE bool Variant::fromJsonFile(const std::string& path, Variant& jsonVariant, std::string* errorStr /*= nullptr*/)
+    {
+        return fromJsonFile(path, jsonVariant, ParseOptions(), errorStr);
+    }
+
+    JSON_VARIANT_INLINE bool Variant::fromJsonFile(const std::string& path, Variant& jsonVariant, const ParseOptions& options, std::string* errorStr /*= nullptr*/)
+    {
+        ParseResult result = parseFile(path, jsonVariant, options);
+        if (!result && errorStr)
+            *errorStr = result.toString();
+
+        return bool(result);
+    }
+
+    JSON_VARIANT_INLINE ParseResult Variant::parseFile(const std::string& path, Variant& jsonVariant, const ParseOptions& options /*= ParseOptions()*/) noexcept
+    {
+        try
+        {
+            JsonSerializationInternal::MappedFile file(path);
+            if (!file.isOpen())
+            {
+                ParseResult result;
+                result.code = ParseErrorCode::FileError;
+                return result;
+            }
+
+            JsonSerializationInternal::ParseContext context(options);
+            return JsonSerializationInternal::JsonParser::parse(file.view(), jsonVariant, context);
+        }
+        catch (const std::bad_alloc&)
+        {
+            ParseResult result;
+            result.code = ParseErrorCode::OutOfMemory;
+            return result;
+        }
+    }
+
+    JSON_VARIANT_INLINE bool Variant::fromJson(const std::string& jsonStr, const std::string& jsonSchema, Variant& jsonVariant, std::string* errorStr /*= nullptr*/)
+    {
+        // a malformed schema or document is reported like any other failure, without an exception
+        ParseResult parseResult;
+        std::shared_ptr<const JsonSerializationInternal::PreparedSchema> pPreparedSchema = JsonSerializationInternal::PreparedSchemaCache::instance().get(jsonSchema, parseResult);
+        if (pPreparedSchema)
+        {
+            JsonSerializationInternal::ParseContext context((ParseOptions()));
+            parseResult = JsonSerializationInternal::JsonParser::parse(jsonStr, jsonVariant, context);
+        }
+
+        if (!parseResult)
+        {
+            if (errorStr)
+                *errorStr = parseResult.toString();
+
+            return false;
+        }
+
+        ValidationResult result;
+        if (JsonSerializationInternal::SchemaValidator::validate(*pPreparedSchema, jsonVariant, result))
+            return true;
+
+        if (errorStr)
+            *errorStr = result[0].toString();
+
+        return false;
+    }
+
+    JSON_VARIANT_INLINE bool Variant::fromJson(const std::string& jsonStr, const CompiledSchema& jsonSchema, Variant& jsonVariant, std::string* errorStr /*= nullptr*/)
+    {
+        ParseResult parseResult = parse(jsonStr, jsonVariant);
+        if (!parseResult)
+        {
+            if (errorStr)
+                *errorStr = parseResult.toString();
+
+            return false;
+        }
+
+        ValidationResult result;
+        if (jsonSchema.validate(jsonVariant, result))
+            return true;
+
+        if (errorStr)
+            *errorStr = result[0].toString();
+
+        return false;
+    }
+
+    JSON_VARIANT_INLINE CompiledSchema::CompiledSchema(std::string_view schemaText)
+    {
+        Variant schemaVariant;
+        ParseResult result = Variant::parse(schemaText, schemaVariant);
+        if (!result)
+            throw std::runtime_error(result.toString());
+
+        pPreparedSchema_ = std::make_shared<const JsonSerializationInternal::PreparedSchema>(std::move(schemaVariant));
+    }
+
+    JSON_VARIANT_INLINE CompiledSchema::CompiledSchema(const Variant& schemaVariant)
+    : pPreparedSchema_(std::make_shared<const JsonSerializationInternal::PreparedSchema>(Variant(schemaVariant)))
+    {
+    }
+
+    JSON_VARIANT_INLINE const Variant& CompiledSchema::schema() const
+    {
+        return pPreparedSchema_->schema();
+    }
+
+    JSON_VARIANT_INLINE bool CompiledSchema::validate(const Variant& jsonVariant, ValidationResult& result) const
+    {
+        return JsonSerializationInternal::SchemaValidator::validate(*pPreparedSchema_, jsonVariant, result);
+    }
+
+    struct Parser::Impl
+    {
+        explicit Impl(const ParseOptions& options)
+        : context(options)
+        {
+        }
+
+        JsonSerializationInternal::ParseContext context;
+    };
+
+    JSON_VARIANT_INLINE Parser::Parser(const ParseOptions& options /*= ParseOptions()*/)
+    : pImpl_(std::make_unique<Impl>(options))
+    {
+    }
+
+    JSON_VARIANT_INLINE Parser::~Parser() = default;
+
+    JSON_VARIANT_INLINE ParseResult Parser::parse(std::string_view jsonStr, Variant& jsonVariant) noexcept
+    {
+        return JsonSerializationInternal::JsonParser::parse(jsonStr, jsonVariant, pImpl_->context);
+    }
+
+    JSON_VARIANT_INLINE ParseResult Parser::parseFile(const std::string& path, Variant& jsonVariant) noexcept
+    {
+        try
+        {
+            JsonSerializationInternal::MappedFile file(path);
+            if (file.isOpen())
+                return JsonSerializationInternal::JsonParser::parse(file.view(), jsonVariant, pImpl_->context);
+        }
+        catch (const std::bad_alloc&)
+        {
+            ParseResult result;
+            result.code = ParseErrorCode::OutOfMemory;
+            return result;
+        }
+
+        ParseResult result;
+        result.code = ParseErrorCode::FileError;
+        return result;
+    }
+
+    JSON_VARIANT_INLINE void Parser::clear()
+    {
+        ParseOptions options = pImpl_->context.options;
+        pImpl_ = std::make_unique<Impl>(options);
+    }
+
+#ifdef __linux__
+    JSON_VARIANT_INLINE EpollScheduler::EpollScheduler()
+    : epollFd_(::epoll_create1(EPOLL_CLOEXEC))
+    {
+    }
+
+    JSON_VARIANT_INLINE EpollScheduler::~EpollScheduler()
+    {
+        if (epollFd_ >= 0)
+            ::close(epollFd_);
+    }
+
+    JSON_VARIANT_INLINE bool EpollScheduler::waitReadable(int fd, std::coroutine_handle<> handle)
+    {
+        if (epollFd_ < 0)
+            return false;
+
+        // one shot registrations stay in the set disabled once they fire, waiting again on the descriptor rearms them
+        epoll_event event{};
+        event.events = EPOLLIN | EPOLLRDHUP | EPOLLONESHOT;
+        event.data.fd = fd;
+        if (::epoll_ctl(epollFd_, EPOLL_CTL_ADD, fd, &event) != 0 && (errno != EEXIST || ::epoll_ctl(epollFd_, EPOLL_CTL_MOD, fd, &event) != 0))
+            return false;
+
+        waiting_[fd] = handle;
+        return true;
+    }
+
+    JSON_VARIANT_INLINE void EpollScheduler::cancel(int fd)
+    {
+        // the descriptor may already be closed, which removed it from the set
+        if (waiting_.erase(fd) > 0)
+            ::epoll_ctl(epollFd_, EPOLL_CTL_DEL, fd, nullptr);
+    }
+
+    JSON_VARIANT_INLINE size_t EpollScheduler::run(int timeoutMs /*= -1*/)
+    {
+        if (waiting_.empty())
+            return 0;
+
+        // a resumed coroutine may destroy another task of the same batch, so handles are looked up at their turn
+        epoll_event events[64];
+        int count = ::epoll_wait(epollFd_, events, 64, timeoutMs);
+        size_t resumed = 0;
+        for (int i = 0; i < count; i++)
+        {
+            auto it = waiting_.find(events[i].data.fd);
+            if (it == waiting_.end())
+                continue;
+
+            std::coroutine_handle<> handle = it->second;
+            waiting_.erase(it);
+            handle.resume();
+            resumed++;
+        }
+
+        return resumed;
+    }
+
+    JSON_VARIANT_INLINE size_t EpollScheduler::pending() const
+    {
+        return waiting_.size();
+    }
+#endif
+
+#ifndef _WIN32
+    JSON_VARIANT_INLINE ParseTask parseAsync(int fd, Variant& jsonVariant, IoScheduler& scheduler, ParseOptions options /*= ParseOptions()*/)
+    {
+        // the document is gathered until the scanner sees its end and parsed at once then
+        constexpr size_t chunkSize = 16384;
+        std::string buffer;
+        JsonSerializationInternal::DocumentScanner scanner;
+        bool complete = false;
+        while (!complete)
+        {
+            size_t size = buffer.size();
+            buffer.resize(size + chunkSize);
+            ssize_t count = ::read(fd, buffer.data() + size, chunkSize);
+            buffer.resize(size + (count > 0 ? count : 0));
+            if (count > 0)
+            {
+                complete = scanner.feed(std::string_view(buffer.data() + size, count));
+                if (buffer.size() > options.maxDocumentSize)
+                    co_return JsonSerializationInternal::failed(ParseErrorCode::DocumentTooLarge);
+            }
+            else if (count == 0)
+                complete = true;
+            else if (errno == EAGAIN || errno == EWOULDBLOCK)
+            {
+                if (!co_await JsonSerializationInternal::ReadableAwaiter(scheduler, fd))
+                    co_return JsonSerializationInternal::failed(ParseErrorCode::FileError);
+            }
+            else if (errno != EINTR)
+                co_return JsonSerializationInternal::failed(ParseErrorCode::FileError);
+        }
+
+        co_return Variant::parse(std::string_view(buffer.data(), std::min(scanner.size(), buffer.size())), jsonVariant, options);
+    }
+#endif
+
+    JSON_VARIANT_INLINE bool Variant::validate(const Variant& schemaVariant, const Variant& jsonVariant, ValidationResult& result)
+    {
+        return JsonSerializationInternal::SchemaValidator::validate(schemaVariant, jsonVariant, result);
+    }
+
+    JSON_VARIANT_INLINE Key::Key(const char* name)
+    : Key(std::string_view(name))
+    {
+    }
+
+    JSON_VARIANT_INLINE Key::Key(const std::string& name)
+    : Key(std::string_view(name))
+    {
+    }
+
+    JSON_VARIANT_INLINE Key::Key(std::string&& name)
+    : Key(std::string_view(name))
+    {
+    }
+
+    JSON_VARIANT_INLINE Key::Key(std::string_view name)
+    : pData_(new Data(name))
+    {
+    }
+
+    struct KeyTable::Impl
+    {
+        std::mutex mutex;
+        std::unordered_map<std::string_view, Key> keys;
+    };
+
+    JSON_VARIANT_INLINE KeyTable::KeyTable()
+    : pImpl_(std::make_unique<Impl>())
+    {
+    }
+
+    JSON_VARIANT_INLINE KeyTable::~KeyTable() = default;
+
+    JSON_VARIANT_INLINE Key KeyTable::intern(std::string_view name)
+    {
+        std::lock_guard<std::mutex> lock(pImpl_->mutex);
+        auto it = pImpl_->keys.find(name);
+        if (it != pImpl_->keys.end())
+            return it->second;
+
+        // interned keys outlive the documents, so not the resource of the one parsed
+        MemoryScope global(nullptr);
+        Key key(name);
+        std::string_view keyName = key.str();
+        return pImpl_->keys.emplace(keyName, std::move(key)).first->second;
+    }
+
+    JSON_VARIANT_INLINE size_t KeyTable::size() const
+    {
+        std::lock_guard<std::mutex> lock(pImpl_->mutex);
+        return pImpl_->keys.size();
+    }
+
+    JSON_VARIANT_INLINE void KeyTable::clear()
+    {
+        std::lock_guard<std::mutex> lock(pImpl_->mutex);
+        pImpl_->keys.clear();
+    }
+
+    JSON_VARIANT_INLINE Shape::Shape(std::vector<Key>&& keys)
+    : keys_(std::move(keys))
+    {
+        // lookups are binary searches, so keys built in declaration order are sorted and the order is remembered
+        if (!std::is_sorted(keys_.begin(), keys_.end()))
+        {
+            std::vector<size_t> order(keys_.size());
+            for (size_t i = 0; i < order.size(); i++)
+                order[i] = i;
+
+            std::sort(order.begin(), order.end(), [this](size_t left, size_t right) { return keys_[left] < keys_[right]; });
+            std::vector<Key> sortedKeys;
+            sortedKeys.reserve(keys_.size());
+            sortedIndices_.resize(keys_.size());
+            for (size_t i = 0; i < order.size(); i++)
+            {
+                sortedKeys.push_back(keys_[order[i]]);
+                sortedIndices_[order[i]] = i;
+            }
+
+            keys_ = std::move(sortedKeys);
+        }
+
+        if (std::adjacent_find(keys_.begin(), keys_.end()) != keys_.end())
+            throw std::runtime_error("Duplicated key in shape");
+    }
+
+    JSON_VARIANT_INLINE size_t Shape::size() const
+    {
+        return keys_.size();
+    }
+
+    JSON_VARIANT_INLINE const Key& Shape::key(size_t index) const
+    {
+        return keys_[index];
+    }
+
+    JSON_VARIANT_INLINE size_t Shape::indexOf(std::string_view name) const
+    {
+        auto it = std::lower_bound(keys_.begin(), keys_.end(), name, [](const Key& key, std::string_view value) { return key.str() < value; });
+        if (it == keys_.end() || it->str() != name)
+            return npos;
+
+        return it - keys_.begin();
+    }
+
+    JSON_VARIANT_INLINE FieldAccessor::FieldAccessor(std::string_view key)
+    : key_(key)
+    {
+    }
+
+    JSON_VARIANT_INLINE const Variant* FieldAccessor::find(const Variant& object)
+    {
+        if (object.kind() != Type::Record)
+            return object.find(key_);
+
+        const Variant::RecordData& record = object.data<Variant::RecordData>();
+        if (record.pShape != pShape_)
+        {
+            pShape_ = record.pShape;
+            index_ = pShape_->indexOf(key_);
+        }
+
+        return index_ == Shape::npos ? nullptr : &record.values[index_];
+    }
+
+    JSON_VARIANT_INLINE const Variant& FieldAccessor::operator()(const Variant& object)
+    {
+        const Variant* pVariant = find(object);
+        if (pVariant == nullptr)
+            throw std::out_of_range("Missing key in map");
+
+        return *pVariant;
+    }
+
+    JSON_VARIANT_INLINE void SchemaCache::setCapacity(size_t capacity)
+    {
+        JsonSerializationInternal::PreparedSchemaCache::instance().setCapacity(capacity);
+    }
+
+    JSON_VARIANT_INLINE size_t SchemaCache::capacity()
+    {
+        return JsonSerializationInternal::PreparedSchemaCache::instance().capacity();
+    }
+
+    JSON_VARIANT_INLINE SchemaCacheStats SchemaCache::stats()
+    {
+        return JsonSerializationInternal::PreparedSchemaCache::instance().stats();
+    }
+
+    JSON_VARIANT_INLINE void SchemaCache::clear()
+    {
+        JsonSerializationInternal::PreparedSchemaCache::instance().clear();
+    }
+
+    JSON_VARIANT_INLINE const char* ParseResult::message() const
+    {
+        switch (code)
+        {
+        case ParseErrorCode::None: return "";
+        case ParseErrorCode::InvalidRoot: return "Json has to be an object or an array";
+        case ParseErrorCode::UnexpectedCharacter: return "Unknown character when parsing value";
+        case ParseErrorCode::InvalidKey: return "Expected key in object";
+        case ParseErrorCode::MissingColon: return "Expected value delimiter";
+        case ParseErrorCode::MissingDelimiter: return "Missing delimiter";
+        case ParseErrorCode::UnfinishedString: return "Not finished string value reading";
+        case ParseErrorCode::InvalidEscape: return "Incorrect escaping in string value reading";
+        case ParseErrorCode::InvalidLiteral: return "Unable to parse literal value";
+        case ParseErrorCode::InvalidNumber: return "Invalid argument when number converting";
+        case ParseErrorCode::NumberOutOfRange: return "Out of range value when number converting";
+        case ParseErrorCode::UnfinishedDocument: return "Unexpected end of json";
+        case ParseErrorCode::TrailingCharacters: return "Unexpected characters after json";
+        case ParseErrorCode::NestingTooDeep: return "Json is nested too deep";
+        case ParseErrorCode::DocumentTooLarge: return "Json is too large";
+        case ParseErrorCode::FileError: return "Unable to read json file";
+        case ParseErrorCode::OutOfMemory: return "Out of memory";
+        }
+
+        return "";
+    }
+
+    JSON_VARIANT_INLINE std::string ParseResult::toString() const
+    {
+        if (line == 0)
+            return message();
+
+        return std::string(message()) + " (at line " + std::to_string(line) + ", column " + std::to_string(column) + ")";
+    }
+
+    JSON_VARIANT_INLINE std::string ValidationError::toString() const
+    {
+        if (path.empty())
+            return message;
+
+        return std::string(message) + " (at " + path + ")";
+    }
+
+    JSON_VARIANT_INLINE ValidationResult::ValidationResult(bool collectAll /*= false*/, size_t capacity /*= 0*/)
+        : size_(0), collectAll_(collectAll)
+    {
+        errors_.reserve(capacity);
+    }
+
+    JSON_VARIANT_INLINE bool ValidationResult::isValid() const
+    {
+        return size_ == 0;
+    }
+
+    JSON_VARIANT_INLINE bool ValidationResult::collectAll() const
+    {
+        return collectAll_;
+    }
+
+    JSON_VARIANT_INLINE void ValidationResult::setCollectAll(bool collectAll)
+    {
+        collectAll_ = collectAll;
+    }
+
+    JSON_VARIANT_INLINE size_t ValidationResult::size() const
+    {
+        return size_;
+    }
+
+    JSON_VARIANT_INLINE const ValidationError& ValidationResult::operator[](size_t index) const
+    {
+        return errors_[index];
+    }
+
+    JSON_VARIANT_INLINE std::span<const ValidationError> ValidationResult::errors() const
+    {
+        return std::span<const ValidationError>(errors_.data(), size_);
+    }
+
+    JSON_VARIANT_INLINE void ValidationResult::clear()
+    {
+        // the error records and their path buffers stay allocated for the next validation
+        size_ = 0;
+    }
+
+    JSON_VARIANT_INLINE void ValidationResult::reserve(size_t capacity)
+    {
+        errors_.reserve(capacity);
+    }
+
+    JSON_VARIANT_INLINE void ValidationResult::add(ValidationErrorCode code, const char* keyword, const char* message, const std::string& path)
+    {
+        if (size_ == errors_.size())
+            errors_.emplace_back();
+
+        ValidationError& error = errors_[size_++];
+        error.code = code;
+        error.keyword = keyword;
+        error.message = message;
+        error.path.assign(path);
+    }
+
+    JSON_VARIANT_INLINE void ValidationResult::append(const ValidationResult& other)
+    {
+        for (const ValidationError& error : other.errors())
+            add(error.code, error.keyword, error.message, error.path);
+    }
+
+    JSON_VARIANT_INLINE Variant::Variant(int value)
+        : Variant((long long)value)
+    {
+    }
+
+    JSON_VARIANT_INLINE Variant::Variant(unsigned int value)
+        : Variant((unsigned long long)value)
+    {
+    }
+
+    JSON_VARIANT_INLINE Variant::Variant(long value)
+        : Variant((long long)value)
+    {
+    }
+
+    JSON_VARIANT_INLINE Variant::Variant(unsigned long value)
+        : Variant((unsigned long long)value)
+    {
+    }
+
+    JSON_VARIANT_INLINE Variant::Variant(long long value)
+    {
+        setInt64(value);
+    }
+
+    JSON_VARIANT_INLINE Variant::Variant(unsigned long long value)
+    {
+        // values which fit are kept as int64 so that equal numbers have the same representation
+        if (value <= (unsigned long long)std::numeric_limits<int64_t>::max())
+            setInt64((int64_t)value);
+        else
+            setUInt64(value);
+    }
+
+    JSON_VARIANT_INLINE Variant::Variant(double value)
+    {
+        setDouble(value);
+    }
+
+    JSON_VARIANT_INLINE Variant::Variant(bool value)
+    {
+        setBool(value);
+    }
+
+    JSON_VARIANT_INLINE Variant::Variant(const char* value)
+    : Variant(std::move(std::string(value)))
+    {
+    }
+
+    JSON_VARIANT_INLINE Variant::Variant(const std::string& value)
+    {
+        create<VariantString>(Type::String, value);
+    }
+
+    JSON_VARIANT_INLINE Variant::Variant(std::string&& value)
+    {
+        create<VariantString>(Type::String, value);
+    }
+
+    JSON_VARIANT_INLINE Variant::Variant(const VariantString& value)
+    {
+        create<VariantString>(Type::String, std::string_view(value));
+    }
+
+    JSON_VARIANT_INLINE Variant::Variant(VariantString&& value)
+    {
+        if (value.get_allocator().resource() == MemoryScope::current())
+            create<VariantString>(Type::String, std::move(value));
+        else
+            create<VariantString>(Type::String, std::string_view(value));
+    }
+
+    JSON_VARIANT_INLINE Variant::Variant(const VariantVector& value)
+    {
+        create<VariantVector>(Type::Vector, value);
+    }
+
+    JSON_VARIANT_INLINE Variant::Variant(VariantVector&& value)
+    {
+        create<VariantVector>(Type::Vector, std::move(value));
+    }
+
+    JSON_VARIANT_INLINE Variant::Variant(const VariantMap& value)
+    {
+        create<VariantMap>(Type::Map, value);
+    }
+
+    JSON_VARIANT_INLINE Variant::Variant(VariantMap&& value)
+    {
+        create<VariantMap>(Type::Map, std::move(value));
+    }
+
+    JSON_VARIANT_INLINE Variant::Variant(const Variant& value)
+    {
+        copyAll(value);
+    }
+
+    JSON_VARIANT_INLINE Variant& Variant::operator=(const Variant& value)
+    {
+        if (this != &value)
+        {
+            // copy first, the value may be a part of this variant
+            Variant copy(value);
+            clear();
+            moveAll(std::move(copy));
+        }
+
+        return *this;
+    }
+
+    JSON_VARIANT_INLINE bool Variant::operator==(const Variant& r) const
+    {
+        if (kind() != r.kind())
+        {
+            // a typed array equals the plain array of the same numbers and a record the map of the same keys and values
+            if ((kind() == Type::Vector && r.kind() == Type::NumberArray) || (kind() == Type::Map && r.kind() == Type::Record))
+                return r == *this;
+
+            if (kind() == Type::Record && r.kind() == Type::Map)
+            {
+                const RecordData& record = data<RecordData>();
+                const VariantMap& variantMap = r.data<VariantMap>();
+                if (record.values.size() != variantMap.size())
+                    return false;
+
+                size_t i = 0;
+                for (const auto& it : variantMap)
+                {
+                    if (!(it.first == record.pShape->key(i)) || !(it.second == record.values[i]))
+                        return false;
+
+                    i++;
+                }
+
+                return true;
+            }
+
+            if (kind() != Type::NumberArray || r.kind() != Type::Vector)
+                return false;
+
+            const VariantVector& variantVector = r.data<VariantVector>();
+            return visitNumberArray([&variantVector](auto numbers)
+            {
+                return numbers.size() == variantVector.size() &&
+                    std::equal(numbers.begin(), numbers.end(), variantVector.begin(), [](auto number, const Variant& v) { return Variant(number) == v; });
+            });
+        }
+
+        switch (kind())
+        {
+        case Type::Empty:
+        case Type::Null:
+            return true;
+
+        case Type::Number:
+            if (numberKind() == NumberType::Int64 && r.numberKind() == NumberType::Int64)
+                return int64Value() == r.int64Value();
+
+            if (numberKind() == NumberType::UInt64 && r.numberKind() == NumberType::UInt64)
+                return uint64Value() == r.uint64Value();
+
+            if (numberKind() != NumberType::Double && r.numberKind() != NumberType::Double)
+                return false;   // normalized int64 and uint64 never overlap
+
+            return toNumber() == r.toNumber();
+
+        case Type::Bool:
+            return boolValue() == r.boolValue();
+
+        case Type::String:
+            return block() == r.block() || data<VariantString>() == r.data<VariantString>();
+
+        case Type::Vector:
+            return block() == r.block() || data<VariantVector>() == r.data<VariantVector>();
+
+        case Type::Map:
+            return block() == r.block() || data<VariantMap>() == r.data<VariantMap>();
+
+        case Type::Record:
+        {
+            if (block() == r.block())
+                return true;
+
+            const RecordData& record = data<RecordData>();
+            const RecordData& other = r.data<RecordData>();
+            if (record.pShape != other.pShape)
+            {
+                if (record.pShape->size() != other.pShape->size())
+                    return false;
+
+                for (size_t i = 0; i < record.pShape->size(); i++)
+                {
+                    if (!(record.pShape->key(i) == other.pShape->key(i)))
+                        return false;
+                }
+            }
+
+            return record.values == other.values;
+        }
+
+        case Type::NumberArray:
+            if (block() == r.block())
+                return true;
+
+            return visitNumberArray([&r](auto numbers)
+            {
+                return r.visitNumberArray([&numbers](auto others)
+                {
+                    return numbers.size() == others.size() &&
+                        std::equal(numbers.begin(), numbers.end(), others.begin(), [](auto number, auto other) { return Variant(number) == Variant(other); });
+                });
+            });
+
+        default:
+            return false;
+        }
+    }
+
+    JSON_VARIANT_INLINE std::span<const double> Variant::toDoubleArray() const
+    {
+        if (kind() == Type::NumberArray && numberKind() == NumberType::Double)
+            return data<NumberVector<double>>();
+
+        throw std::runtime_error("Not double array in variant");
+    }
+
+    JSON_VARIANT_INLINE std::span<const int64_t> Variant::toInt64Array() const
+    {
+        if (kind() == Type::NumberArray && numberKind() == NumberType::Int64)
+            return data<NumberVector<int64_t>>();
+
+        throw std::runtime_error("Not int64 array in variant");
+    }
+
+    JSON_VARIANT_INLINE Variant Variant::numberArray(std::vector<double>&& values)
+    {
+        Variant variant;
+        variant.setBlock(new SharedData<NumberVector<double>>(values.begin(), values.end()), Type::NumberArray, NumberType::Double);
+        return variant;
+    }
+
+    JSON_VARIANT_INLINE Variant Variant::numberArray(std::vector<int64_t>&& values)
+    {
+        Variant variant;
+        variant.setBlock(new SharedData<NumberVector<int64_t>>(values.begin(), values.end()), Type::NumberArray, NumberType::Int64);
+        return variant;
+    }
+
+    JSON_VARIANT_INLINE const Shape& Variant::shape() const
+    {
+        if (kind() == Type::Record)
+            return *data<RecordData>().pShape;
+
+        throw std::runtime_error("Not record in variant");
+    }
+
+    JSON_VARIANT_INLINE std::span<const Variant> Variant::recordValues() const
+    {
+        if (kind() == Type::Record)
+            return data<RecordData>().values;
+
+        throw std::runtime_error("Not record in variant");
+    }
+
+    JSON_VARIANT_INLINE Variant Variant::record(std::shared_ptr<const Shape> pShape, VariantVector&& values)
+    {
+        if (!pShape || pShape->size() != values.size())
+            throw std::runtime_error("Record values do not match its shape");
+
+        if (!pShape->sortedIndices_.empty())
+        {
+            VariantVector sortedValues(values.size());
+            for (size_t i = 0; i < values.size(); i++)
+                sortedValues[pShape->sortedIndices_[i]] = std::move(values[i]);
+
+            values = std::move(sortedValues);
+        }
+
+        Variant variant;
+        variant.create<RecordData>(Type::Record, std::move(pShape), std::move(values));
+        return variant;
+    }
+
+    JSON_VARIANT_INLINE VariantString& Variant::toMutableString()
+    {
+        if (kind() != Type::String)
+            throw std::runtime_error("Not string in variant");
+
+        detach();
+        return data<VariantString>();
+    }
+
+    JSON_VARIANT_INLINE VariantVector& Variant::toMutableVector()
+    {
+        if (kind() != Type::Vector)
+            throw std::runtime_error("Not vector in variant");
+
+        detach();
+        return data<VariantVector>();
+    }
+
+    JSON_VARIANT_INLINE VariantMap& Variant::toMutableMap()
+    {
+        if (kind() != Type::Map)
+            throw std::runtime_error("Not map in variant");
+
+        detach();
+        return data<VariantMap>();
+    }
+
+    JSON_VARIANT_INLINE VariantString Variant::takeString() &&
+    {
+        if (kind() != Type::String)
+            throw std::runtime_error("Not string in variant");
+
+        return takeData<VariantString>();
+    }
+
+    JSON_VARIANT_INLINE VariantVector Variant::takeVector() &&
+    {
+        if (kind() != Type::Vector)
+            throw std::runtime_error("Not vector in variant");
+
+        return takeData<VariantVector>();
+    }
+
+    JSON_VARIANT_INLINE VariantMap Variant::takeMap() &&
+    {
+        if (kind() != Type::Map)
+            throw std::runtime_error("Not map in variant");
+
+        return takeData<VariantMap>();
+    }
+
+    JSON_VARIANT_INLINE std::string Variant::toJson(bool pretty/* = false*/) const
+    {
+        JsonSerializationInternal::OperationScope scope(Operation::Serialize);
+        int intend = 0;
+        std::string jsonStr = pretty ? _toJson(intend) : _toJson();
+        scope.finish(true, jsonStr.size(), this);
+        return jsonStr;
+    }
+
+    template <typename T> T Variant::takeData()
+    {
+        // data shared with copies has to stay as it is for them
+        SharedData<T>* pShared = static_cast<SharedData<T>*>(block());
+        T value;
+        if (pShared->refCount.load(std::memory_order_acquire) == 1)
+            value = std::move(pShared->value);
+        else
+            value = pShared->value;
+
+        clear();
+        return value;
+    }
+
+    template <typename T> void Variant::detachData()
+    {
+        SharedData<T>* pShared = static_cast<SharedData<T>*>(block());
+        if (pShared->refCount.load(std::memory_order_acquire) == 1)
+            return;
+
+        // the old block is dropped through a variant so that it is freed properly if it became the last reference meanwhile
+        Variant previous;
+        previous.copyStorage(*this);
+        setBlock(new SharedData<T>(pShared->value), kind(), numberKind());
+    }
+
+    JSON_VARIANT_INLINE void Variant::detach()
+    {
+        switch (kind())
+        {
+        case Type::String:
+            detachData<VariantString>();
+            break;
+
+        case Type::Vector:
+            detachData<VariantVector>();
+            break;
+
+        case Type::Map:
+            detachData<VariantMap>();
+            break;
+
+        case Type::Record:
+            detachData<RecordData>();
+            break;
+
+        case Type::NumberArray:
+            if (numberKind() == NumberType::Double)
+                detachData<NumberVector<double>>();
+            else
+                detachData<NumberVector<int64_t>>();
+            break;
+
+        default:
+            break;
+        }
+    }
+
+    JSON_VARIANT_INLINE void Variant::releaseShallow(std::vector<Variant>& pending)
+    {
+        // frees this node only, its containers are moved to pending so the children are emptied before their parent dies
+        SharedBlock* pShared = block();
+        Type type = kind();
+        NumberType numberType = numberKind();
+        setEmpty();
+        if (pShared->refCount.fetch_sub(1, std::memory_order_acq_rel) != 1)
+            return;
+
+        auto releaseChild = [&pending](Variant& child)
+        {
+            if (child.kind() == Type::Vector || child.kind() == Type::Map || child.kind() == Type::Record)
+                pending.push_back(std::move(child));
+            else if (child.hasBlock())
+                child.releaseShallow(pending);
+        };
+
+        switch (type)
+        {
+        case Type::Number:  // integers boxed by the compact layout
+            if (numberType == NumberType::Int64)
+                delete static_cast<SharedData<int64_t>*>(pShared);
+            else
+                delete static_cast<SharedData<uint64_t>*>(pShared);
+            break;
+
+        case Type::String:
+            delete static_cast<SharedData<VariantString>*>(pShared);
+            break;
+
+        case Type::Vector:
+        {
+            SharedData<VariantVector>* pVector = static_cast<SharedData<VariantVector>*>(pShared);
+            for (Variant& child : pVector->value)
+                releaseChild(child);
+
+            delete pVector;
+        }
+        break;
+
+        case Type::Map:
+        {
+            SharedData<VariantMap>* pMap = static_cast<SharedData<VariantMap>*>(pShared);
+            for (auto& it : pMap->value)
+                releaseChild(it.second);
+
+            delete pMap;
+        }
+        break;
+
+        case Type::Record:
+        {
+            SharedData<RecordData>* pRecord = static_cast<SharedData<RecordData>*>(pShared);
+            for (Variant& child : pRecord->value.values)
+                releaseChild(child);
+
+            delete pRecord;
+        }
+        break;
+
+        case Type::NumberArray:
+            if (numberType == NumberType::Double)
+                delete static_cast<SharedData<NumberVector<double>>*>(pShared);
+            else
+                delete static_cast<SharedData<NumberVector<int64_t>>*>(pShared);
+            break;
+
+        default:
+            break;
+        }
+    }
+
+    JSON_VARIANT_INLINE void Variant::clear()
+    {
+        if (hasBlock())
+        {
+            std::vector<Variant> pending;
+            releaseShallow(pending);
+            while (!pending.empty())
+            {
+                Variant variant(std::move(pending.back()));
+                pending.pop_back();
+                variant.releaseShallow(pending);
+            }
+        }
+
+        setEmpty();
+    }
+
+    JSON_VARIANT_INLINE void Variant::releaseAsync()
+    {
+        if (kind() != Type::Vector && kind() != Type::Map && kind() != Type::NumberArray && kind() != Type::Record)
+        {
+            clear();
+            return;
+        }
+
+        Variant variant(std::move(*this));
+        if (!JsonSerializationInternal::BackgroundReleaser::instance().release(std::move(variant)))
+            variant.clear();
+    }
+
+    JSON_VARIANT_INLINE void Instrumentation::setCallback(Callback callback)
+    {
+        std::shared_ptr<const Callback> pCallback;
+        if (callback)
+            pCallback = std::make_shared<const Callback>(std::move(callback));
+
+        std::lock_guard<std::mutex> lock(JsonSerializationInternal::instrumentationMutex);
+        JsonSerializationInternal::pInstrumentationCallback = std::move(pCallback);
+        JsonSerializationInternal::instrumentationEnabled.store(compiledIn && JsonSerializationInternal::pInstrumentationCallback, std::memory_order_relaxed);
+    }
+
+    JSON_VARIANT_INLINE bool Instrumentation::enabled()
+    {
+        return JsonSerializationInternal::instrumentationEnabled.load(std::memory_order_relaxed);
+    }
+
+    JSON_VARIANT_INLINE OperationStats Instrumentation::lastStats()
+    {
+        return JsonSerializationInternal::lastOperationStats;
+    }
+
+    JSON_VARIANT_INLINE MemoryScope::MemoryScope(std::pmr::memory_resource* pResource) noexcept
+    : pPrevious_(JsonSerializationInternal::pCurrentMemoryResource)
+    {
+        JsonSerializationInternal::pCurrentMemoryResource = pResource;
+    }
+
+    JSON_VARIANT_INLINE MemoryScope::~MemoryScope()
+    {
+        JsonSerializationInternal::pCurrentMemoryResource = pPrevious_;
+    }
+
+    JSON_VARIANT_INLINE std::pmr::memory_resource* MemoryScope::current() noexcept
+    {
+        return JsonSerializationInternal::pCurrentMemoryResource;
+    }
+
+    JSON_VARIANT_INLINE void Variant::setCopyOnWrite(bool enabled)
+    {
+        JsonSerializationInternal::copyOnWriteEnabled.store(enabled, std::memory_order_relaxed);
+    }
+
+    JSON_VARIANT_INLINE bool Variant::copyOnWrite()
+    {
+        return JsonSerializationInternal::copyOnWriteEnabled.load(std::memory_order_relaxed);
+    }
+
+    JSON_VARIANT_INLINE void Variant::copyAll(const Variant& value)
+    {
+        if (!value.hasBlock())
+        {
+            copyStorage(value);
+            return;
+        }
+
+        if (JsonSerializationInternal::copyOnWriteEnabled.load(std::memory_order_relaxed))
+        {
+            value.block()->refCount.fetch_add(1, std::memory_order_relaxed);
+            copyStorage(value);
+            return;
+        }
+
+        const Type type = value.kind();
+        const NumberType numberType = value.numberKind();
+        switch (type)
+        {
+        case Type::Number:
+            if (numberType == NumberType::Int64)
+                setBlock(new SharedData<int64_t>(value.data<int64_t>()), type, numberType);
+            else
+                setBlock(new SharedData<uint64_t>(value.data<uint64_t>()), type, numberType);
+            break;
+
+        case Type::String:
+            setBlock(new SharedData<VariantString>(value.data<VariantString>()), type, numberType);
+            break;
+
+        case Type::Vector:
+            setBlock(new SharedData<VariantVector>(value.data<VariantVector>()), type, numberType);
+            break;
+
+        case Type::Map:
+            setBlock(new SharedData<VariantMap>(value.data<VariantMap>()), type, numberType);
+            break;
+
+        case Type::Record:
+            setBlock(new SharedData<RecordData>(value.data<RecordData>()), type, numberType);
+            break;
+
+        case Type::NumberArray:
+            if (numberType == NumberType::Double)
+                setBlock(new SharedData<NumberVector<double>>(value.data<NumberVector<double>>()), type, numberType);
+            else
+                setBlock(new SharedData<NumberVector<int64_t>>(value.data<NumberVector<int64_t>>()), type, numberType);
+            break;
+
+        default:
+            setEmpty();
+            break;
+        }
+    }
+
+    JSON_VARIANT_INLINE std::string Variant::numberToJson() const
+    {
+        // shortest representation which reads back to the same value, integers never go through floating point
+        char buffer[32];
+        std::to_chars_result result;
+        switch (numberKind())
+        {
+        case NumberType::Int64:
+            result = std::to_chars(buffer, buffer + sizeof(buffer), int64Value());
+            break;
+
+        case NumberType::UInt64:
+            result = std::to_chars(buffer, buffer + sizeof(buffer), uint64Value());
+            break;
+
+        default:
+            if (!std::isfinite(doubleValue()))
+                return "null";
+
+            result = std::to_chars(buffer, buffer + sizeof(buffer), doubleValue());
+            break;
+        }
+
+        return std::string(buffer, result.ptr);
+    }
+
+    JSON_VARIANT_INLINE std::string Variant::_toJson() const
+    {
+        switch (kind())
+        {
+        case Type::Null:
+            return "null";
+
+        case Type::Number:
+            return numberToJson();
+
+        case Type::Bool:
+            return boolValue() ? "true" : "false";
+
+        case Type::String:
+            return "\"" + std::string(data<VariantString>()) + "\"";
+
+        case Type::Vector:
+        {
+            VariantVector* pJsonVariantVector = &data<VariantVector>();
+            if (pJsonVariantVector->empty())
+            {
+                return "[]";
+            }
+            else
+            {
+                std::string resultStr("[");
+                for (Variant& jsonVariant : *pJsonVariantVector)
+                    resultStr += jsonVariant._toJson() + ",";
+
+                resultStr[resultStr.size() - 1] = ']';
+                return resultStr;
+            }
+        }
+        break;
+
+        case Type::NumberArray:
+            return visitNumberArray([](auto numbers)
+            {
+                std::string resultStr("[");
+                for (auto number : numbers)
+                    resultStr += Variant(number).numberToJson() + ",";
+
+                if (numbers.empty())
+                    resultStr.push_back(']');
+                else
+                    resultStr[resultStr.size() - 1] = ']';
+
+                return resultStr;
+            });
+
+        case Type::Map:
+        {
+            VariantMap* pJsonVariantMap = &data<VariantMap>();
+            if (pJsonVariantMap->empty())
+            {
+                return "{}";
+            }
+            else
+            {
+                std::string resultStr("{");
+                for (auto& it : *pJsonVariantMap)
+                    resultStr += "\"" + std::string(it.first.str()) + "\":" + it.second._toJson() + ",";
+
+                resultStr[resultStr.size() - 1] = '}';
+                return resultStr;
+            }
+        }
+        break;
+
+        case Type::Record:
+        {
+            const RecordData& record = data<RecordData>();
+            if (record.values.empty())
+                return "{}";
+
+            std::string resultStr("{");
+            for (size_t i = 0; i < record.values.size(); i++)
+                resultStr += "\"" + std::string(record.pShape->key(i).str()) + "\":" + record.values[i]._toJson() + ",";
+
+            resultStr[resultStr.size() - 1] = '}';
+            return resultStr;
+        }
+
+        default:
+            return "";
+        }
+
+        return "";
+    }
+
+    JSON_VARIANT_INLINE std::string Variant::_toJson(int& intend) const
+    {
+        switch (kind())
+        {
+        case Type::Null:
+            return "null";
+
+        case Type::Number:
+            return numberToJson();
+
+        case Type::Bool:
+            return boolValue() ? "true" : "false";
+
+        case Type::String:
+            return "\"" + std::string(data<VariantString>()) + "\"";
+
+        case Type::Vector:
+        {
+            VariantVector* pJsonVariantVector = &data<VariantVector>();
+            if (pJsonVariantVector->empty())
+            {
+                return "[]";
+            }
+            else
+            {
+                intend += 4;
+                std::string resultStr("[" + JsonSerializationInternal::endLineStr);
+                for (Variant& jsonVariant : *pJsonVariantVector)
+                {
+                    if (intend > 0)
+                        resultStr += std::string(intend, ' ');
+
+                    resultStr += jsonVariant._toJson(intend) + "," + JsonSerializationInternal::endLineStr;
+                }
+
+                intend -= 4;
+                resultStr.pop_back();
+                resultStr.pop_back();
+                resultStr += JsonSerializationInternal::endLineStr + std::string(intend, ' ') + "]";
+                return resultStr;
+            }
+        }
+        break;
+
+        case Type::NumberArray:
+            return visitNumberArray([&intend](auto numbers)
+            {
+                if (numbers.empty())
+                    return std::string("[]");
+
+                std::string resultStr("[" + JsonSerializationInternal::endLineStr);
+                for (auto number : numbers)
+                    resultStr += std::string(intend + 4, ' ') + Variant(number).numberToJson() + "," + JsonSerializationInternal::endLineStr;
+
+                resultStr.pop_back();
+                resultStr.pop_back();
+                resultStr += JsonSerializationInternal::endLineStr + std::string(intend, ' ') + "]";
+                return resultStr;
+            });
+
+        case Type::Map:
+        {
+            VariantMap* pJsonVariantMap = &data<VariantMap>();
+            if (pJsonVariantMap->empty())
+            {
+                return "{}";
+            }
+            else
+            {
+                std::string resultStr("{");
+                intend += 4;
+                for (auto& it : *pJsonVariantMap)
+                {
+                    resultStr += JsonSerializationInternal::endLineStr;
+                    if (intend > 0)
+                        resultStr += std::string(intend, ' ');
+
+                    resultStr += "\"" + std::string(it.first.str()) + "\": " + it.second._toJson(intend) + ",";
+                }
+
+                intend -= 4;
+                resultStr.pop_back();
+                resultStr += JsonSerializationInternal::endLineStr + std::string(intend, ' ') + "}";
+                return resultStr;
+            }
+        }
+        break;
+
+        case Type::Record:
+        {
+            const RecordData& record = data<RecordData>();
+            if (record.values.empty())
+                return "{}";
+
+            std::string resultStr("{");
+            intend += 4;
+            for (size_t i = 0; i < record.values.size(); i++)
+            {
+                resultStr += JsonSerializationInternal::endLineStr;
+                if (intend > 0)
+                    resultStr += std::string(intend, ' ');
+
+                resultStr += "\"" + std::string(record.pShape->key(i).str()) + "\": " + record.values[i]._toJson(intend) + ",";
+            }
+
+            intend -= 4;
+            resultStr.pop_back();
+            resultStr += JsonSerializationInternal::endLineStr + std::string(intend, ' ') + "}";
+            return resultStr;
+        }
+
+        default:
+            return "";
+        }
+
+        return "";
+    }
+
+    JSON_VARIANT_INLINE void Variant::_value(int& val) const
+    {
+        val = toInt();
+    }
+
+    JSON_VARIANT_INLINE void Variant::_value(unsigned int& val) const
+    {
+        uint64_t value = toUInt64();
+        if (value > std::numeric_limits<unsigned int>::max())
+            throw std::runtime_error("Number out of range in variant");
+
+        val = (unsigned int)value;
+    }
+
+    JSON_VARIANT_INLINE void Variant::_value(long& val) const
+    {
+        val = (long)toInt64();
+    }
+
+    JSON_VARIANT_INLINE void Variant::_value(unsigned long& val) const
+    {
+        val = (unsigned long)toUInt64();
+    }
+
+    JSON_VARIANT_INLINE void Variant::_value(long long& val) const
+    {
+        val = toInt64();
+    }
+
+    JSON_VARIANT_INLINE void Variant::_value(unsigned long long& val) const
+    {
+        val = toUInt64();
+    }
+
+    JSON_VARIANT_INLINE void Variant::_value(double& val) const
+    {
+        val = toNumber();
+    }
+
+    JSON_VARIANT_INLINE void Variant::_value(float& val) const
+    {
+        val = (float)toNumber();
+    }
+
+    JSON_VARIANT_INLINE void Variant::_value(bool& val) const
+    {
+        if (kind() == Type::Bool)
+            val = boolValue();
+        else
+            throw std::runtime_error("Not bool in variant");
+    }
+
+    JSON_VARIANT_INLINE void Variant::_value(std::string& val) const
+    {
+        if (kind() == Type::String)
+            val = data<VariantString>();
+        else
+            throw std::runtime_error("Not string in variant");
+    }
+}
+
+#endif
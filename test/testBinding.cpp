@@ -0,0 +1,130 @@
+#include <catch2/catch_all.hpp>
+#include "../include/jsonBinding.h"
+
+namespace {
+    struct Player {
+        std::string name;
+        double averageScoring = 0.0;
+    };
+
+    struct Address {
+        std::string city;
+        std::string country;
+    };
+
+    struct Team {
+        int id = -1;
+        std::string coach;
+        std::string assistant = "none";
+        bool active = false;
+        Address address;
+        std::vector<Player> players;
+        std::vector<int64_t> identificators;
+    };
+}
+
+template <> struct JsonSerialization::Binding<Player> {
+    static constexpr auto fields = std::make_tuple(
+        JSON_FIELD(Player, name),
+        JSON_FIELD(Player, averageScoring));
+};
+
+template <> struct JsonSerialization::Binding<Address> {
+    static constexpr auto fields = std::make_tuple(
+        JSON_FIELD(Address, city),
+        JSON_FIELD(Address, country));
+};
+
+template <> struct JsonSerialization::Binding<Team> {
+    static constexpr auto fields = std::make_tuple(
+        JSON_FIELD(Team, id),
+        JSON_FIELD(Team, coach),
+        JSON_FIELD(Team, assistant),
+        JSON_FIELD(Team, active),
+        JSON_FIELD(Team, address),
+        JSON_FIELD(Team, players),
+        JSON_FIELD(Team, identificators));
+};
+
+TEST_CASE("Bind json to structs", "[bindingDecode]") {
+    Team team;
+    std::string errorStr;
+    REQUIRE(JsonSerialization::fromJson(R"(
+    {
+        "id": 7,
+        "coach": "Samuel \"Sam\" Motivator",
+        "assistant": null,
+        "sponsor": { "name": "Tatra [mountains]", "years": [2019, 2020] },
+        "active": true,
+        "address": { "city": "Poprad", "country": "Slovakia" },
+        "players": [ { "name": "Stephen", "averageScoring": 16.4 }, { "name": "Geoffrey", "averageScoring": 12.7 } ],
+        "identificators": [1, 2, 9007199254740993]
+    }
+    )", team, &errorStr));
+
+    REQUIRE(team.id == 7);
+    REQUIRE(team.coach == R"(Samuel \"Sam\" Motivator)");
+    REQUIRE(team.assistant == "none");
+    REQUIRE(team.active);
+    REQUIRE(team.address.country == "Slovakia");
+    REQUIRE(team.players.size() == 2);
+    REQUIRE(team.players[1].name == "Geoffrey");
+    REQUIRE(team.players[1].averageScoring == 12.7);
+    REQUIRE(team.identificators == std::vector<int64_t>{ 1, 2, 9007199254740993LL });
+
+    std::vector<Player> players;
+    REQUIRE(JsonSerialization::fromJson(R"([{"name": "Anthony"}])", players));
+    REQUIRE(players.size() == 1);
+    REQUIRE(players[0].averageScoring == 0.0);
+
+    REQUIRE_FALSE(JsonSerialization::fromJson(R"({"id": 7.5})", team, &errorStr));
+    REQUIRE(errorStr == "Invalid argument when number converting");
+    REQUIRE_FALSE(JsonSerialization::fromJson(R"({"id": 3000000000})", team, &errorStr));
+    REQUIRE(errorStr == "Out of range value when number converting");
+    REQUIRE_FALSE(JsonSerialization::fromJson(R"({"coach": "Samuel")", team, &errorStr));
+    REQUIRE_FALSE(JsonSerialization::fromJson(R"({"id": 7} 8)", team, &errorStr));
+
+    // values of unknown keys have to be valid json as well
+    REQUIRE_FALSE(JsonSerialization::fromJson(R"({"sponsor": [1,, tru x], "id": 3})", team, &errorStr));
+    REQUIRE_FALSE(JsonSerialization::fromJson(R"({"sponsor": [}, "id": 3})", team, &errorStr));
+    REQUIRE_FALSE(JsonSerialization::fromJson(R"({"sponsor": {"name" "Tatra"}, "id": 3})", team, &errorStr));
+    REQUIRE_FALSE(JsonSerialization::fromJson(R"({"sponsor": {"name": "Tatra",}, "id": 3})", team, &errorStr));
+    REQUIRE_FALSE(JsonSerialization::fromJson(R"({"sponsor": [[1], [2]}, "id": 3})", team, &errorStr));
+    REQUIRE(JsonSerialization::fromJson(R"({"sponsor": [[], {}, [{"a": [null, false]}]], "id": 3})", team, &errorStr));
+    REQUIRE(team.id == 3);
+
+    // keys end at the first unescaped quote
+    REQUIRE(JsonSerialization::fromJson(R"({"say \"id\"": 5, "id": 4})", team, &errorStr));
+    REQUIRE(team.id == 4);
+}
+
+TEST_CASE("Write bound structs as json", "[bindingEncode]") {
+    Team team;
+    team.id = 7;
+    team.coach = "Samuel Motivator";
+    team.active = true;
+    team.address = { "Poprad", "Slovakia" };
+    team.players = { { "Stephen", 16.4 }, { "Geoffrey", 12.7 } };
+    team.identificators = { 1, 2, 9007199254740993LL };
+
+    std::string json = JsonSerialization::toJson(team);
+    REQUIRE(json == R"({"id":7,"coach":"Samuel Motivator","assistant":"none","active":true,"address":{"city":"Poprad","country":"Slovakia"},"players":[{"name":"Stephen","averageScoring":16.4},{"name":"Geoffrey","averageScoring":12.7}],"identificators":[1,2,9007199254740993]})");
+
+    Team decoded;
+    REQUIRE(JsonSerialization::fromJson(json, decoded));
+    REQUIRE(JsonSerialization::toJson(decoded) == json);
+
+    std::string out = "[";
+    JsonSerialization::toJson(std::vector<Player>{ { "Anthony", std::nan("") } }, out);
+    REQUIRE(out == R"([[{"name":"Anthony","averageScoring":null}])");
+
+    // strings are json escaped text, they are written as they are or not at all
+    Player player{ R"(Samuel \"Sam\"\n)", 1.5 };
+    REQUIRE(JsonSerialization::toJson(player) == R"({"name":"Samuel \"Sam\"\n","averageScoring":1.5})");
+    player.name = "say \"hi\"";
+    REQUIRE_THROWS_WITH(JsonSerialization::toJson(player), "Unescaped character in string value writing");
+    player.name = "two\nlines";
+    REQUIRE_THROWS_WITH(JsonSerialization::toJson(player), "Unescaped character in string value writing");
+    player.name = "trailing \\";
+    REQUIRE_THROWS_WITH(JsonSerialization::toJson(player), "Incorrect escaping in string value writing");
+}
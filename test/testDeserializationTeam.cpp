@@ -1,6 +1,10 @@
 #define CATCH_CONFIG_MAIN  // This defines the main() function for Catch2
 #include <catch2/catch_all.hpp>
 #include "../include/jsonVariant.h"
+#include "../include/jsonLiteral.h"
+
+#include <filesystem>
+#include <fstream>
 
 namespace {
     std::string teamJson{ R"(
@@ -69,4 +73,315 @@ TEST_CASE("Unserialize Team JSON", "[unserializeTeam]") {
 
     REQUIRE(success);
     REQUIRE(errorStr.empty());
-}
\ No newline at end of file
+}
+
+TEST_CASE("Validate large homogeneous array", "[validateLargeArray]") {
+    std::string schema{ R"({"type": "object", "properties": {"samples": {"type": "array", "items": {"type": "number", "minimum": 0}}}, "required": ["samples"]})" };
+    std::string json("{\"samples\": [");
+    for (int i = 0; i < 20000; i++)
+    {
+        if (i == 3000)
+            json += "-1,";
+        else if (i == 15000)
+            json += "\"x\",";
+        else
+            json += std::to_string(i) + ",";
+    }
+
+    json.back() = ']';
+    json += "}";
+
+    JsonSerialization::Variant variant;
+    std::string errorStr;
+    REQUIRE_FALSE(JsonSerialization::Variant::fromJson(json, schema, variant, &errorStr));
+    REQUIRE(errorStr == "Numeric value is smaller than minimum (at /samples/3000)");
+
+    JsonSerialization::ValidationResult result(true);
+    REQUIRE_FALSE(JsonSerialization::Variant::validate(JsonSerialization::Variant(), variant, result));
+    REQUIRE(result[0].code == JsonSerialization::ValidationErrorCode::InvalidSchema);
+
+    JsonSerialization::Variant schemaVariant;
+    REQUIRE(JsonSerialization::Variant::fromJson(schema, schemaVariant));
+    REQUIRE_FALSE(JsonSerialization::Variant::validate(schemaVariant, variant, result));
+    REQUIRE(result.size() == 2);
+    REQUIRE(result[0].path == "/samples/3000");
+    REQUIRE(std::string(result[0].keyword) == "minimum");
+    REQUIRE(result[1].path == "/samples/15000");
+    REQUIRE(result[1].code == JsonSerialization::ValidationErrorCode::Type);
+}
+
+TEST_CASE("Collect all validation errors", "[validationErrors]") {
+    std::string json{ R"({"id": 7.5, "coach": "Sam", "address": {"city": "Poprad"}, "players": [{"name": "Stephen"}], "identificators": [1, 2]})" };
+    JsonSerialization::Variant schemaVariant, variant;
+    REQUIRE(JsonSerialization::Variant::fromJson(teamSchema, schemaVariant));
+    REQUIRE(JsonSerialization::Variant::fromJson(json, variant));
+
+    JsonSerialization::ValidationResult result(true, 8);
+    REQUIRE_FALSE(JsonSerialization::Variant::validate(schemaVariant, variant, result));
+    REQUIRE(result.size() == 4);
+    REQUIRE(result[0].path == "/address/country");
+    REQUIRE(result[0].code == JsonSerialization::ValidationErrorCode::Required);
+    REQUIRE(result[1].path == "/coach");
+    REQUIRE(result[1].code == JsonSerialization::ValidationErrorCode::MinLength);
+    REQUIRE(result[2].path == "/id");
+    REQUIRE(result[3].path == "/players/0/averageScoring");
+
+    result.setCollectAll(false);
+    REQUIRE_FALSE(JsonSerialization::Variant::validate(schemaVariant, variant, result));
+    REQUIRE(result.size() == 1);
+}
+
+TEST_CASE("Store numeric arrays contiguously", "[typedArrays]") {
+    JsonSerialization::ParseOptions options;
+    options.typedArrays = true;
+    JsonSerialization::Variant variant;
+    REQUIRE(JsonSerialization::Variant::fromJson(R"({"ids": [1, 2, 3, -4], "samples": [1, 2.5, -0.25], "mixed": [1, "two"], "nested": [[1], [2]], "big": [1, 18446744073709551615]})", variant, options));
+
+    const JsonSerialization::VariantMap& map = variant.toMap();
+    REQUIRE(map("ids").type() == JsonSerialization::Type::NumberArray);
+    REQUIRE(map("ids").numberType() == JsonSerialization::NumberType::Int64);
+    REQUIRE(map("ids").toInt64Array().size() == 4);
+    REQUIRE(map("ids").toInt64Array()[3] == -4);
+    REQUIRE_THROWS(map("ids").toDoubleArray());
+
+    std::span<const double> samples = map("samples").toDoubleArray();
+    REQUIRE(samples.size() == 3);
+    REQUIRE(samples[0] == 1.0);
+    REQUIRE(samples[2] == -0.25);
+
+    REQUIRE(map("mixed").type() == JsonSerialization::Type::Vector);
+    REQUIRE(map("nested").type() == JsonSerialization::Type::Vector);
+    REQUIRE(map("nested").toVector()[0].type() == JsonSerialization::Type::NumberArray);
+    REQUIRE(map("big").type() == JsonSerialization::Type::Vector);
+
+    std::vector<double> values;
+    map("samples").valueVector(values);
+    REQUIRE(values == std::vector<double>{ 1.0, 2.5, -0.25 });
+    std::vector<int> ids;
+    map("ids").valueVector(ids);
+    REQUIRE(ids == std::vector<int>{ 1, 2, 3, -4 });
+
+    JsonSerialization::Variant plain;
+    REQUIRE(JsonSerialization::Variant::fromJson(R"({"ids": [1, 2, 3, -4], "samples": [1, 2.5, -0.25], "mixed": [1, "two"], "nested": [[1], [2]], "big": [1, 18446744073709551615]})", plain));
+    REQUIRE(plain == variant);
+    REQUIRE(variant.toJson() == plain.toJson());
+    REQUIRE(variant.toJson(true) == plain.toJson(true));
+
+    JsonSerialization::Variant schema;
+    REQUIRE(JsonSerialization::Variant::fromJson(R"({"type": "object", "properties": {"ids": {"type": "array", "items": {"type": "integer", "maximum": 2}}}})", schema));
+    JsonSerialization::ValidationResult result;
+    REQUIRE_FALSE(JsonSerialization::Variant::validate(schema, variant, result));
+    REQUIRE(result[0].path == "/ids/2");
+}
+
+TEST_CASE("Share shapes of same keyed objects", "[shapes]") {
+    const std::string json = R"({"players": [{"name": "Ann", "score": 12}, {"score": 7, "name": "Bob"}, {"name": "Cid", "score": 3, "name": "Dan"}], "coach": {"name": "Eve"}})";
+    JsonSerialization::ParseOptions options;
+    options.shareShapes = true;
+    JsonSerialization::Variant variant;
+    REQUIRE(JsonSerialization::Variant::fromJson(json, variant, options));
+    REQUIRE(variant.type() == JsonSerialization::Type::Record);
+
+    const JsonSerialization::Variant& players = *variant.find("players");
+    const JsonSerialization::VariantVector& playerVector = players.toVector();
+    REQUIRE(playerVector[0].type() == JsonSerialization::Type::Record);
+    REQUIRE(&playerVector[0].shape() == &playerVector[1].shape());
+    REQUIRE(&playerVector[0].shape() == &playerVector[2].shape());
+    REQUIRE(&playerVector[0].shape() != &variant.find("coach")->shape());
+    REQUIRE(playerVector[0].shape().size() == 2);
+    REQUIRE(playerVector[0].shape().indexOf("score") == 1);
+    REQUIRE(playerVector[0].shape().indexOf("id") == JsonSerialization::Shape::npos);
+    REQUIRE(playerVector[2].find("name")->toString() == "Cid");
+    REQUIRE(variant.find("id") == nullptr);
+
+    JsonSerialization::FieldAccessor score("score");
+    int total = 0;
+    for (const JsonSerialization::Variant& player : playerVector)
+        total += score(player).toInt();
+
+    REQUIRE(total == 22);
+    REQUIRE_THROWS(JsonSerialization::FieldAccessor("id")(playerVector[0]));
+
+    JsonSerialization::Variant plain;
+    REQUIRE(JsonSerialization::Variant::fromJson(json, plain));
+    REQUIRE(score(plain.toMap()("players").toVector()[1]).toInt() == 7);
+    REQUIRE(plain == variant);
+    REQUIRE(variant == plain);
+    REQUIRE(variant.toJson() == plain.toJson());
+    REQUIRE(variant.toJson(true) == plain.toJson(true));
+
+    JsonSerialization::Variant schema;
+    REQUIRE(JsonSerialization::Variant::fromJson(R"({"type": "object", "properties": {"players": {"type": "array", "items": {"type": "object", "properties": {"score": {"type": "integer", "minimum": 5}}}}}})", schema));
+    JsonSerialization::ValidationResult result;
+    REQUIRE_FALSE(JsonSerialization::Variant::validate(schema, variant, result));
+    REQUIRE(result[0].path == "/players/2/score");
+
+    // shapes built in declaration order are sorted and the values follow their keys
+    auto pShape = std::make_shared<const JsonSerialization::Shape>(std::vector<JsonSerialization::Key>{ "score", "name" });
+    JsonSerialization::Variant built = JsonSerialization::Variant::record(pShape, JsonSerialization::VariantVector{ 12, "Ann" });
+    REQUIRE(pShape->key(0) == "name");
+    REQUIRE(built.find("name")->toString() == "Ann");
+    REQUIRE(score(built).toInt() == 12);
+    REQUIRE(built == playerVector[0]);
+    JsonSerialization::Variant uniqueSchema(JsonSerialization::VariantMap{ { "uniqueItems", true } });
+    REQUIRE_FALSE(JsonSerialization::Variant::validate(uniqueSchema, JsonSerialization::VariantVector{ built, playerVector[0] }, result));
+    REQUIRE_THROWS_AS(JsonSerialization::Shape(std::vector<JsonSerialization::Key>{ "name", "score", "name" }), std::runtime_error);
+}
+
+TEST_CASE("Parse json files", "[jsonFile]") {
+    std::filesystem::path path = std::filesystem::temp_directory_path() / "jsonVariantTeam.json";
+    {
+        std::ofstream file(path, std::ios::binary);
+        file << teamJson;
+    }
+
+    JsonSerialization::Variant fileVariant, variant;
+    std::string errorStr;
+    REQUIRE(JsonSerialization::Variant::fromJsonFile(path.string(), fileVariant, &errorStr));
+    REQUIRE(JsonSerialization::Variant::fromJson(teamJson, variant));
+    REQUIRE(fileVariant == variant);
+
+    JsonSerialization::Parser parser;
+    REQUIRE(parser.parseFile(path.string(), variant));
+    REQUIRE(fileVariant == variant);
+
+    {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    }
+
+    REQUIRE(JsonSerialization::Variant::parseFile(path.string(), variant).code == JsonSerialization::ParseErrorCode::UnfinishedDocument);
+    std::filesystem::remove(path);
+    REQUIRE_FALSE(JsonSerialization::Variant::fromJsonFile(path.string(), variant, &errorStr));
+    REQUIRE(errorStr == "Unable to read json file");
+}
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <unistd.h>
+
+TEST_CASE("Parse from descriptors asynchronously", "[parseAsync]") {
+    JsonSerialization::EpollScheduler scheduler;
+    int first[2], second[2];
+    REQUIRE(::pipe2(first, O_NONBLOCK) == 0);
+    REQUIRE(::pipe2(second, O_NONBLOCK) == 0);
+
+    JsonSerialization::Variant firstVariant, secondVariant, variant;
+    JsonSerialization::ParseTask firstTask = JsonSerialization::parseAsync(first[0], firstVariant, scheduler);
+    JsonSerialization::ParseTask secondTask = JsonSerialization::parseAsync(second[0], secondVariant, scheduler);
+    REQUIRE_FALSE(firstTask.done());
+    REQUIRE(scheduler.pending() == 2);
+
+    // the first document arrives in two parts and is complete without closing the pipe
+    size_t half = teamJson.size() / 2;
+    REQUIRE(::write(first[1], teamJson.data(), half) == (ssize_t)half);
+    REQUIRE(scheduler.run(1000) == 1);
+    REQUIRE_FALSE(firstTask.done());
+    REQUIRE(::write(first[1], teamJson.data() + half, teamJson.size() - half) == (ssize_t)(teamJson.size() - half));
+    REQUIRE(scheduler.run(1000) == 1);
+    REQUIRE(firstTask.done());
+    REQUIRE(firstTask.result());
+    REQUIRE(JsonSerialization::Variant::fromJson(teamJson, variant));
+    REQUIRE(firstVariant == variant);
+
+    // the second one is cut short by closing the pipe
+    REQUIRE(::write(second[1], "{\"id\": [1, ", 11) == 11);
+    ::close(second[1]);
+    while (!secondTask.done())
+        scheduler.run(1000);
+
+    REQUIRE(secondTask.result().code == JsonSerialization::ParseErrorCode::UnfinishedDocument);
+    REQUIRE(secondTask.result().column == 12);
+    REQUIRE(scheduler.pending() == 0);
+
+    ::close(first[0]);
+    ::close(first[1]);
+    ::close(second[0]);
+}
+
+TEST_CASE("Drop pending parse tasks", "[parseAsync]") {
+    JsonSerialization::EpollScheduler scheduler;
+    int dropped[2], kept[2];
+    REQUIRE(::pipe2(dropped, O_NONBLOCK) == 0);
+    REQUIRE(::pipe2(kept, O_NONBLOCK) == 0);
+
+    JsonSerialization::Variant droppedVariant, keptVariant;
+    JsonSerialization::ParseTask keptTask = JsonSerialization::parseAsync(kept[0], keptVariant, scheduler);
+    {
+        JsonSerialization::ParseTask droppedTask = JsonSerialization::parseAsync(dropped[0], droppedVariant, scheduler);
+        REQUIRE(scheduler.pending() == 2);
+    }
+
+    // the descriptor of the destroyed task becomes readable but its frame is gone
+    REQUIRE(scheduler.pending() == 1);
+    REQUIRE(::write(dropped[1], "[1]", 3) == 3);
+    REQUIRE(scheduler.run(0) == 0);
+    REQUIRE(scheduler.pending() == 1);
+
+    REQUIRE(::write(kept[1], "[2]", 3) == 3);
+    REQUIRE(scheduler.run(1000) == 1);
+    REQUIRE(keptTask.done());
+    REQUIRE(keptVariant == JsonSerialization::Variant(JsonSerialization::VariantVector{ 2 }));
+    REQUIRE(droppedVariant == JsonSerialization::Variant());
+
+    ::close(dropped[0]);
+    ::close(dropped[1]);
+    ::close(kept[0]);
+    ::close(kept[1]);
+}
+#endif
+
+TEST_CASE("Check json literals at compile time", "[jsonLiteral]") {
+    using namespace JsonSerialization::Literals;
+    constexpr JsonSerialization::JsonLiteral schemaLiteral = R"({"type": "object", "required": ["id", "coach"], "properties": {"id": {"type": "integer"}}})";
+    static_assert(JsonSerialization::checkJson(schemaLiteral));
+    static_assert(JsonSerialization::checkJson(R"({"a": [1, 2,]})").code == JsonSerialization::ParseErrorCode::UnexpectedCharacter);
+    static_assert(JsonSerialization::checkJson("[1]\n]").line == 2);
+    static_assert(JsonSerialization::checkJson("[1.8e308]").code == JsonSerialization::ParseErrorCode::NumberOutOfRange);
+
+    // the range of doubles right at the bounds from_chars rounds to infinity or zero from
+    std::vector<std::string> corpus = { "{}", " [ ] ", "{\"a\": 1}", "[1, 2,]", "{\"a\" 1}", "{\"a\": tru}", "[1 2]", "[\"x\\q\"]", "[\"open",
+        "[-]", "[1e]", "[1e999]", "[1e-999]", "[-.5]", "[1.]", "[0.00012e-2]", " 5", "{\"a\": 1}}", "{1: 2}", "[nul]", "[\n1,\n  2,\n  x]", "[[[", "",
+        "[1.8e308]", "[-1.8e308]", "[2e-324]", "[-2e-324]", "[4e-324]", "[1e-310]", "[0e999999]", "[0.000e-400]", "[18446744073709551616]",
+        "[1.7976931348623157e308]", "[1.7976931348623158e308]", "[1.7976931348623159e308]", "[2.4703282292062328e-324]", "[2.4703282292062327e-324]",
+        "[0.0000179769313486231580e313]", "[1797.69313486231580e305]" };
+    for (const JsonSerializationInternal::DecimalBound* pBound : { &JsonSerializationInternal::overflowBound, &JsonSerializationInternal::underflowBound })
+    {
+        // exactly at the bound, just above it and just below it
+        std::string digits(pBound->digits.data(), pBound->size);
+        std::string exponent = "e" + std::to_string(pBound->exponent) + "]";
+        std::string below = digits;
+        size_t last = below.find_last_not_of('0');
+        below[last]--;
+        corpus.push_back("[" + digits.substr(0, 1) + "." + digits.substr(1) + exponent);
+        corpus.push_back("[" + digits.substr(0, 1) + "." + digits.substr(1) + "0001" + exponent);
+        corpus.push_back("[" + below.substr(0, 1) + "." + below.substr(1) + "999" + exponent);
+    }
+
+    // the checks at compile time report what the parser reports
+    for (std::string_view text : corpus)
+    {
+        JsonSerialization::Variant variant;
+        JsonSerialization::ParseResult parsed = JsonSerialization::Variant::parse(text, variant);
+        JsonSerialization::ParseResult checked = JsonSerialization::checkJson(text);
+        INFO(text);
+        REQUIRE(checked.code == parsed.code);
+        REQUIRE(checked.offset == parsed.offset);
+        REQUIRE(checked.line == parsed.line);
+        REQUIRE(checked.column == parsed.column);
+    }
+
+    JsonSerialization::CompiledSchema schema(schemaLiteral);
+    REQUIRE(schema.schema().toMap()("type").toString() == "object");
+    JsonSerialization::Variant teamVariant;
+    std::string errorStr;
+    REQUIRE(JsonSerialization::Variant::fromJson(teamJson, schema, teamVariant, &errorStr));
+    REQUIRE_FALSE(JsonSerialization::Variant::fromJson(R"({"id": "seven", "coach": "Samuel"})", schema, teamVariant, &errorStr));
+    REQUIRE_FALSE(errorStr.empty());
+    REQUIRE_FALSE(JsonSerialization::Variant::fromJson(R"({"id": 7,)", schema, teamVariant, &errorStr));
+    REQUIRE(errorStr == JsonSerialization::checkJson(R"({"id": 7,)").toString());
+    REQUIRE_THROWS_AS(JsonSerialization::CompiledSchema(std::string_view("{")), std::runtime_error);
+
+    JsonSerialization::Variant defaults = R"({"retries": 3, "hosts": ["a", "b"]})"_json.variant();
+    REQUIRE(defaults.toMap()("retries").toInt() == 3);
+    REQUIRE(defaults.toMap()("hosts").toVector().size() == 2);
+}
@@ -65,3 +65,135 @@ TEST_CASE("Unserialize Veggie JSON", "[unserializeVeggie]") {
     REQUIRE(success);  // Catch2 equivalent of EXPECT_TRUE
     REQUIRE(errorStr.empty());  // Ensure no error message was produced
 }
+
+TEST_CASE("Reuse cached schema", "[schemaCache]") {
+    JsonSerialization::SchemaCache::clear();
+    JsonSerialization::Variant veggieVariant;
+    for (int i = 0; i < 3; i++)
+        REQUIRE(JsonSerialization::Variant::fromJson(vegieJson, veggieSchema, veggieVariant));
+
+    JsonSerialization::SchemaCacheStats stats = JsonSerialization::SchemaCache::stats();
+    REQUIRE(stats.misses == 1);
+    REQUIRE(stats.hits == 2);
+    REQUIRE(stats.size == 1);
+
+    size_t capacity = JsonSerialization::SchemaCache::capacity();
+    JsonSerialization::SchemaCache::setCapacity(1);
+    REQUIRE(JsonSerialization::Variant::fromJson("[1]", R"({"type": "array"})", veggieVariant));
+    stats = JsonSerialization::SchemaCache::stats();
+    REQUIRE(stats.evictions == 1);
+    REQUIRE(stats.size == 1);
+
+    std::string errorStr;
+    REQUIRE_FALSE(JsonSerialization::Variant::fromJson(vegieJson, "{\"type\": ", veggieVariant, &errorStr));
+    REQUIRE(errorStr == "Unexpected end of json (at line 1, column 10)");
+    REQUIRE_FALSE(JsonSerialization::Variant::fromJson("{\"a\": -}", R"({"type": "array"})", veggieVariant, &errorStr));
+    REQUIRE(errorStr == "Invalid argument when number converting (at line 1, column 7)");
+    REQUIRE_FALSE(JsonSerialization::Variant::fromJson(vegieJson, "[1]", veggieVariant, &errorStr));
+    REQUIRE(errorStr == "Bad schema type");
+    JsonSerialization::SchemaCache::setCapacity(capacity);
+}
+
+TEST_CASE("Intern map keys", "[internKeys]") {
+    JsonSerialization::Variant variant;
+    REQUIRE(JsonSerialization::Variant::fromJson(R"([{"name": "tomato", "color": "red"}, {"name": "cucumber", "color": "green"}])", variant));
+    const JsonSerialization::VariantVector& veggies = variant.toVector();
+    REQUIRE(&veggies[0].toMap().find("name")->first.str() == &veggies[1].toMap().find("name")->first.str());
+
+    JsonSerialization::KeyTable keyTable;
+    JsonSerialization::ParseOptions options;
+    options.pKeyTable = &keyTable;
+    JsonSerialization::Variant first, second;
+    REQUIRE(JsonSerialization::Variant::fromJson(R"({"name": "tomato", "color": "red"})", first, options));
+    REQUIRE(JsonSerialization::Variant::fromJson(R"({"name": "carrot", "weight": 61})", second, options));
+    REQUIRE(keyTable.size() == 3);
+    REQUIRE(&first.toMap().find("name")->first.str() == &second.toMap().find(std::string("name"))->first.str());
+    REQUIRE(second.toMap()("weight").toInt() == 61);
+    REQUIRE_THROWS_AS(second.toMap()("color"), std::out_of_range);
+
+    keyTable.clear();
+    REQUIRE(keyTable.size() == 0);
+    REQUIRE(first.toJson() == R"({"color":"red","name":"tomato"})");
+}
+
+TEST_CASE("Reuse one parser", "[parser]") {
+    JsonSerialization::Parser parser;
+    JsonSerialization::Variant first, second, plain;
+    REQUIRE(parser.parse(vegieJson, first));
+    REQUIRE(JsonSerialization::Variant::fromJson(vegieJson, plain));
+    REQUIRE(first == plain);
+
+    REQUIRE_FALSE(parser.parse(R"({"name": "tomato", "color": [1, 2)", second));
+
+    REQUIRE(parser.parse(R"({"name": "carrot", "tags": ["root", "orange"], "weight": 61})", second));
+    REQUIRE(second.toJson() == R"({"name":"carrot","tags":["root","orange"],"weight":61})");
+    REQUIRE(parser.parse(R"({"name": "pepper", "weight": 160})", plain));
+    REQUIRE(&second.toMap().find("name")->first.str() == &plain.toMap().find("name")->first.str());
+
+    JsonSerialization::ParseOptions options;
+    options.shareShapes = true;
+    JsonSerialization::Parser recordParser(options);
+    REQUIRE(recordParser.parse(R"({"name": "tomato", "color": "red"})", first));
+    REQUIRE(recordParser.parse(R"({"color": "green", "name": "cucumber"})", second));
+    REQUIRE(&first.shape() == &second.shape());
+
+    recordParser.clear();
+    REQUIRE(recordParser.parse(R"({"name": "tomato", "color": "red"})", plain));
+    REQUIRE(&first.shape() != &plain.shape());
+    REQUIRE(first == plain);
+}
+
+TEST_CASE("Report parse error positions", "[parseErrors]") {
+    JsonSerialization::Variant variant;
+    JsonSerialization::ParseResult result = JsonSerialization::Variant::parse("{\n  \"name\": \"tomato\",\n  \"weight\": 1x\n}", variant);
+    REQUIRE_FALSE(result);
+    REQUIRE(result.code == JsonSerialization::ParseErrorCode::MissingDelimiter);
+    REQUIRE(result.offset == 35);
+    REQUIRE(result.line == 3);
+    REQUIRE(result.column == 14);
+    REQUIRE(result.toString() == "Missing delimiter (at line 3, column 14)");
+    REQUIRE(variant.isEmpty());
+
+    REQUIRE(JsonSerialization::Variant::parse("{\"name\": \"tomato\"}", variant).code == JsonSerialization::ParseErrorCode::None);
+    REQUIRE(JsonSerialization::Variant::parse("[1, 2", variant).code == JsonSerialization::ParseErrorCode::UnfinishedDocument);
+    REQUIRE(JsonSerialization::Variant::parse("\"tomato\"", variant).code == JsonSerialization::ParseErrorCode::InvalidRoot);
+    REQUIRE(JsonSerialization::Variant::parse("{\"a\": tru}", variant).code == JsonSerialization::ParseErrorCode::InvalidLiteral);
+    REQUIRE(JsonSerialization::Variant::parse("{\"a\": \"\\x\"}", variant).offset == 7);
+    REQUIRE(JsonSerialization::Variant::parse("{\"a\" 1}", variant).code == JsonSerialization::ParseErrorCode::MissingColon);
+    REQUIRE(JsonSerialization::Variant::parse("{\"a\": 1} x", variant).column == 10);
+    REQUIRE(JsonSerialization::Variant::parse("{\"a\": 1e999}", variant).code == JsonSerialization::ParseErrorCode::NumberOutOfRange);
+    REQUIRE(variant.toMap()("name").toString() == "tomato");
+
+    REQUIRE(JsonSerialization::Variant::parse(" [ ] ", variant));
+    REQUIRE(variant.toVector().empty());
+    REQUIRE(JsonSerialization::Variant::parse("{\"a\": [], \"b\": {}}", variant));
+    REQUIRE(variant.toJson() == R"({"a":[],"b":{}})");
+
+    std::string errorStr;
+    REQUIRE_FALSE(JsonSerialization::Variant::fromJson("{\"a\": -}", variant, &errorStr));
+    REQUIRE(errorStr == "Invalid argument when number converting (at line 1, column 7)");
+}
+
+TEST_CASE("Limit nesting and size", "[parseLimits]") {
+    std::string deep = std::string(100000, '[') + std::string(100000, ']');
+    JsonSerialization::Variant variant;
+    JsonSerialization::ParseResult result = JsonSerialization::Variant::parse(deep, variant);
+    REQUIRE(result.code == JsonSerialization::ParseErrorCode::NestingTooDeep);
+    REQUIRE(result.offset == 512);
+
+    JsonSerialization::ParseOptions options;
+    options.maxDepth = 3;
+    REQUIRE(JsonSerialization::Variant::parse(R"({"a": [{"b": 1}, []]})", variant, options));
+    REQUIRE(variant.toJson() == R"({"a":[{"b":1},[]]})");
+    REQUIRE(JsonSerialization::Variant::parse(R"({"a": [{"b": []}]})", variant, options).code == JsonSerialization::ParseErrorCode::NestingTooDeep);
+
+    options.maxDepth = 200000;
+    REQUIRE(JsonSerialization::Variant::parse(deep, variant, options));
+    variant.releaseAsync();
+
+    options.maxDocumentSize = 8;
+    REQUIRE(JsonSerialization::Variant::parse(R"({"a": 1})", variant, options));
+    result = JsonSerialization::Variant::parse(R"({"a": 10})", variant, options);
+    REQUIRE(result.code == JsonSerialization::ParseErrorCode::DocumentTooLarge);
+    REQUIRE(result.offset == 0);
+}
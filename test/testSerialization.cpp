@@ -4,3 +4,299 @@
 TEST_CASE("First test", "Test serialization") {
     REQUIRE(0 == 0);
 }
+
+TEST_CASE("Keep 64-bit integers exact", "[serializeInteger]") {
+    JsonSerialization::Variant variant;
+    REQUIRE(JsonSerialization::Variant::fromJson(R"({"id": 9007199254740993, "big": 18446744073709551615, "min": -9223372036854775808, "ts": 1700000000123456789, "score": 16.4, "exp": 1.5e3, "huge": 18446744073709551616})", variant));
+
+    const JsonSerialization::VariantMap& map = variant.toMap();
+    REQUIRE(map("id").numberType() == JsonSerialization::NumberType::Int64);
+    REQUIRE(map("id").toInt64() == 9007199254740993LL);
+    REQUIRE(map("big").numberType() == JsonSerialization::NumberType::UInt64);
+    REQUIRE(map("big").toUInt64() == 18446744073709551615ULL);
+    REQUIRE(map("min").toInt64() == std::numeric_limits<int64_t>::min());
+    REQUIRE(map("ts").value<long long>() == 1700000000123456789LL);
+    REQUIRE(map("score").numberType() == JsonSerialization::NumberType::Double);
+    REQUIRE(map("exp").toDouble() == 1500.0);
+    REQUIRE(map("huge").numberType() == JsonSerialization::NumberType::Double);
+    REQUIRE_THROWS(map("big").toInt64());
+    REQUIRE_THROWS(map("min").toUInt64());
+    REQUIRE_THROWS(map("huge").toInt64());
+    REQUIRE_THROWS(map("huge").toUInt64());
+    REQUIRE_THROWS(map("id").toInt());
+    REQUIRE_THROWS(JsonSerialization::Variant(-1.5).toUInt64());
+    REQUIRE_THROWS(JsonSerialization::Variant(std::nan("")).toInt64());
+    REQUIRE_THROWS(JsonSerialization::Variant(1e300).toInt());
+    REQUIRE(JsonSerialization::Variant(-0.5).toUInt64() == 0);
+    REQUIRE(JsonSerialization::Variant(-9223372036854775808.0).toInt64() == std::numeric_limits<int64_t>::min());
+    REQUIRE(JsonSerialization::Variant(int64_t(-2147483648LL)).toInt() == std::numeric_limits<int>::min());
+
+    REQUIRE(variant.toJson() == R"({"big":18446744073709551615,"exp":1500,"huge":18446744073709551616,"id":9007199254740993,"min":-9223372036854775808,"score":16.4,"ts":1700000000123456789})");
+    REQUIRE(JsonSerialization::Variant(1) == JsonSerialization::Variant(1.0));
+    REQUIRE_FALSE(JsonSerialization::Variant(int64_t(9007199254740993LL)) == JsonSerialization::Variant(int64_t(9007199254740992LL)));
+}
+
+TEST_CASE("Share copied subtrees", "[copyOnWrite]") {
+    JsonSerialization::Variant variant;
+    REQUIRE(JsonSerialization::Variant::fromJson(R"({"name": "tomato", "tags": ["red", "round"], "nutrition": {"kcal": 18}})", variant));
+
+    JsonSerialization::Variant::setCopyOnWrite(true);
+    JsonSerialization::Variant copy(variant);
+    REQUIRE(&copy.toMap() == &variant.toMap());
+    REQUIRE(copy == variant);
+
+    JsonSerialization::Variant tags = variant.toMap()("tags");
+    variant = JsonSerialization::Variant("replaced");
+    REQUIRE(variant.toString() == "replaced");
+    REQUIRE(copy.toMap()("tags") == tags);
+    REQUIRE(copy.toJson() == R"({"name":"tomato","nutrition":{"kcal":18},"tags":["red","round"]})");
+
+    copy = copy.toMap()("nutrition");
+    REQUIRE(copy.toJson() == R"({"kcal":18})");
+
+    JsonSerialization::Variant::setCopyOnWrite(false);
+    JsonSerialization::Variant deepCopy(copy);
+    REQUIRE(&deepCopy.toMap() != &copy.toMap());
+    REQUIRE(deepCopy == copy);
+}
+
+static JsonSerialization::Variant deepVariant(int depth) {
+    JsonSerialization::Variant variant("leaf");
+    for (int i = 0; i < depth; i++) {
+        JsonSerialization::VariantVector variantVector;
+        variantVector.push_back(std::move(variant));
+        variant = JsonSerialization::Variant(std::move(variantVector));
+    }
+
+    return variant;
+}
+
+// made before the first release and destroyed after the background thread was joined at exit
+static struct ReleasedAtExit {
+    JsonSerialization::Variant document = deepVariant(1000);
+    ~ReleasedAtExit() { document.releaseAsync(); }
+} releasedAtExit;
+
+TEST_CASE("Release deep documents", "[release]") {
+    JsonSerialization::Variant variant = deepVariant(200000);
+    variant = JsonSerialization::Variant();
+    REQUIRE(variant.type() == JsonSerialization::Type::Empty);
+
+    JsonSerialization::Variant::setCopyOnWrite(true);
+    JsonSerialization::Variant shared = deepVariant(200000);
+    JsonSerialization::Variant copy(shared);
+    JsonSerialization::Variant::setCopyOnWrite(false);
+    shared = JsonSerialization::Variant();
+    REQUIRE(copy.type() == JsonSerialization::Type::Vector);
+
+    copy.releaseAsync();
+    REQUIRE(copy.type() == JsonSerialization::Type::Empty);
+
+    JsonSerialization::Variant document;
+    REQUIRE(JsonSerialization::Variant::fromJson(R"({"veggies": ["tomato", "cucumber"], "count": 2})", document));
+    JsonSerialization::Variant kept(document.toMap()("veggies"));
+    document.releaseAsync();
+    REQUIRE(document.type() == JsonSerialization::Type::Empty);
+    REQUIRE(kept.toJson() == R"(["tomato","cucumber"])");
+}
+
+TEST_CASE("Move data out of variants", "[take]") {
+    JsonSerialization::Variant variant;
+    REQUIRE(JsonSerialization::Variant::fromJson(R"({"name": "a fairly long veggie name", "weights": [61, 72, 18], "tags": ["red", "round"]})", variant));
+
+    JsonSerialization::VariantMap map = std::move(variant).takeMap();
+    REQUIRE(variant.isEmpty());
+
+    const JsonSerialization::VariantString* pName = &map("name").toString();
+    const char* pChars = pName->data();
+    JsonSerialization::VariantString name = std::move(map.find("name")->second).takeString();
+    REQUIRE(name == "a fairly long veggie name");
+    REQUIRE(name.data() == pChars);
+    REQUIRE_THROWS(std::move(map.find("weights")->second).takeString());
+
+    std::vector<int> weights;
+    std::move(map.find("weights")->second).valueVector(weights);
+    REQUIRE(weights == std::vector<int>{ 61, 72, 18 });
+
+    JsonSerialization::Variant::setCopyOnWrite(true);
+    JsonSerialization::Variant tags = map("tags");
+    JsonSerialization::Variant shared(tags);
+    JsonSerialization::Variant::setCopyOnWrite(false);
+    tags.toMutableVector().push_back("green");
+    REQUIRE(tags.toVector().size() == 3);
+    REQUIRE(shared.toVector().size() == 2);
+
+    std::vector<std::string> sharedTags;
+    std::move(shared).valueVector(sharedTags);
+    REQUIRE(sharedTags == std::vector<std::string>{ "red", "round" });
+    REQUIRE(map("tags").toJson() == R"(["red","round"])");
+}
+
+TEST_CASE("Keep values in either layout", "[layout]") {
+#ifdef JSON_VARIANT_NAN_BOXING
+    REQUIRE(sizeof(JsonSerialization::Variant) == 8);
+#endif
+    JsonSerialization::VariantVector values{ nullptr, true, false, 0, -1, 140737488355327LL, -140737488355329LL, std::numeric_limits<int64_t>::min(), std::numeric_limits<uint64_t>::max(), 0.5, -0.0, std::numeric_limits<double>::infinity(), std::nan(""), "text" };
+    JsonSerialization::Variant variant(values);
+    JsonSerialization::Variant copy(variant);
+    REQUIRE_FALSE(copy == variant);     // NaN is not equal to itself
+    REQUIRE(copy.toJson() == R"([null,true,false,0,-1,140737488355327,-140737488355329,-9223372036854775808,18446744073709551615,0.5,-0,null,null,"text"])");
+
+    const JsonSerialization::VariantVector& copied = copy.toVector();
+    REQUIRE(copied[0].isNull());
+    REQUIRE(copied[2].type() == JsonSerialization::Type::Bool);
+    REQUIRE_FALSE(copied[2].toBool());
+    REQUIRE(copied[6].toInt64() == -140737488355329LL);
+    REQUIRE(copied[6] == values[6]);
+    REQUIRE(copied[8] == values[8]);
+    REQUIRE(copied[7].numberType() == JsonSerialization::NumberType::Int64);
+    REQUIRE(copied[8].numberType() == JsonSerialization::NumberType::UInt64);
+    REQUIRE(copied[12].numberType() == JsonSerialization::NumberType::Double);
+    REQUIRE(std::isnan(copied[12].toDouble()));
+    REQUIRE(JsonSerialization::Variant().isEmpty());
+}
+
+TEST_CASE("Report operation statistics", "[instrumentation]") {
+    std::vector<JsonSerialization::OperationStats> reported;
+    JsonSerialization::Instrumentation::setCallback([&reported](const JsonSerialization::OperationStats& stats) { reported.push_back(stats); });
+    REQUIRE(JsonSerialization::Instrumentation::enabled() == JsonSerialization::Instrumentation::compiledIn);
+
+    const std::string json = R"({"name": "tomato", "tags": ["red", "round"], "weight": 120})";
+    JsonSerialization::Variant variant;
+    REQUIRE(JsonSerialization::Variant::fromJson(json, variant));
+    std::string jsonStr = variant.toJson();
+    JsonSerialization::Instrumentation::setCallback(nullptr);
+    REQUIRE_FALSE(JsonSerialization::Instrumentation::enabled());
+    REQUIRE(variant.toJson() == jsonStr);
+
+    if constexpr (JsonSerialization::Instrumentation::compiledIn)
+    {
+        REQUIRE(reported.size() == 2);
+        const JsonSerialization::OperationStats& parse = reported[0];
+        REQUIRE(parse.operation == JsonSerialization::Operation::Parse);
+        REQUIRE(parse.succeeded);
+        REQUIRE(parse.bytes == json.size());
+        REQUIRE(parse.nodes[size_t(JsonSerialization::Type::Map)] == 1);
+        REQUIRE(parse.nodes[size_t(JsonSerialization::Type::Vector)] == 1);
+        REQUIRE(parse.nodes[size_t(JsonSerialization::Type::String)] == 3);
+        REQUIRE(parse.nodes[size_t(JsonSerialization::Type::Number)] == 1);
+        REQUIRE(parse.maxDepth == 3);
+        REQUIRE(parse.allocations == 5);
+        REQUIRE(parse.allocatedBytes > 0);
+
+        REQUIRE(reported[1].operation == JsonSerialization::Operation::Serialize);
+        REQUIRE(reported[1].bytes == jsonStr.size());
+        REQUIRE(reported[1].allocations == 0);
+        REQUIRE(JsonSerialization::Instrumentation::lastStats().operation == JsonSerialization::Operation::Serialize);
+    }
+    else
+    {
+        REQUIRE(reported.empty());
+    }
+}
+
+namespace
+{
+    // counts the bytes in use and refuses to go over a limit like a per request budget
+    class LimitedResource : public std::pmr::memory_resource
+    {
+    public:
+        explicit LimitedResource(size_t limit) : limit_(limit) {}
+
+        size_t used = 0;
+        size_t allocations = 0;
+
+    private:
+        void* do_allocate(size_t bytes, size_t alignment) override
+        {
+            if (used + bytes > limit_)
+                throw std::bad_alloc();
+
+            used += bytes;
+            allocations++;
+            return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+        }
+
+        void do_deallocate(void* p, size_t bytes, size_t alignment) override
+        {
+            used -= bytes;
+            std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+        }
+
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+        size_t limit_;
+    };
+}
+
+TEST_CASE("Allocate blocks from a memory resource", "[memoryResource]") {
+    const std::string json = R"({"name": "tomato", "tags": ["red", "round"], "weight": 120, "id": 9007199254740993})";
+    LimitedResource resource(1 << 20);
+    JsonSerialization::ParseOptions options;
+    options.pMemoryResource = &resource;
+    JsonSerialization::Variant variant;
+    REQUIRE(JsonSerialization::Variant::parse(json, variant, options));
+    REQUIRE(resource.allocations > 0);
+    REQUIRE(resource.used > 0);
+    REQUIRE(JsonSerialization::MemoryScope::current() == nullptr);
+
+    // deep copies made outside of any scope use the global heap but share the keys, released memory goes back where
+    // it came from
+    size_t used = resource.used;
+    JsonSerialization::Variant copy = variant;
+    REQUIRE(resource.used == used);
+    variant = JsonSerialization::Variant();
+    REQUIRE(resource.used > 0);
+    REQUIRE(resource.used < used);
+    REQUIRE(copy.toMap()("tags").toVector().size() == 2);
+    copy = JsonSerialization::Variant();
+    REQUIRE(resource.used == 0);
+
+    {
+        JsonSerialization::MemoryScope scope(&resource);
+        JsonSerialization::Variant text("kept in the resource");
+        REQUIRE(resource.used > 0);
+        {
+            JsonSerialization::MemoryScope inner(nullptr);
+            REQUIRE(JsonSerialization::MemoryScope::current() == nullptr);
+        }
+
+        REQUIRE(JsonSerialization::MemoryScope::current() == &resource);
+    }
+
+    REQUIRE(resource.used == 0);
+
+    LimitedResource small(64);
+    options.pMemoryResource = &small;
+    JsonSerialization::ParseResult result = JsonSerialization::Variant::parse(json, variant, options);
+    REQUIRE(result.code == JsonSerialization::ParseErrorCode::OutOfMemory);
+    REQUIRE(small.used == 0);
+
+    // the characters, elements and keys owned by the blocks are counted too
+    options.typedArrays = true;
+    auto resourceBytes = [&options](const std::string& text)
+    {
+        LimitedResource counting(1 << 20);
+        options.pMemoryResource = &counting;
+        JsonSerialization::Variant parsed;
+        REQUIRE(JsonSerialization::Variant::parse(text, parsed, options));
+        return counting.used;
+    };
+
+    auto numbers = [](size_t count)
+    {
+        std::string text = "[0";
+        for (size_t i = 1; i < count; i++)
+            text += ", " + std::to_string(i);
+
+        return text + "]";
+    };
+
+    REQUIRE(resourceBytes("[\"" + std::string(100000, 'x') + "\"]") - resourceBytes("[\"" + std::string(100, 'x') + "\"]") >= 99900);
+    REQUIRE(resourceBytes("{\"" + std::string(100000, 'k') + "\": 1}") - resourceBytes("{\"" + std::string(100, 'k') + "\": 1}") >= 99900);
+    REQUIRE(resourceBytes(numbers(10000)) - resourceBytes(numbers(10)) >= 9990 * sizeof(int64_t));
+    options.typedArrays = false;
+    REQUIRE(resourceBytes("[" + numbers(10000) + "]") - resourceBytes("[" + numbers(10) + "]") >= 9990 * sizeof(JsonSerialization::Variant));
+    options.shareShapes = true;
+    REQUIRE(resourceBytes(R"([{"a": 1, "b": 2}, {"a": 3, "b": 4}])") > resourceBytes(R"([{"a": 1}])"));
+}
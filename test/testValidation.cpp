@@ -0,0 +1,183 @@
+#include <catch2/catch_all.hpp>
+#include "../include/jsonVariant.h"
+
+namespace {
+    bool validString(const std::string& format, const std::string& value)
+    {
+        JsonSerialization::Variant schemaVariant(JsonSerialization::VariantMap{ { "type", "string" }, { "format", format } });
+        JsonSerialization::ValidationResult result;
+        return JsonSerialization::Variant::validate(schemaVariant, JsonSerialization::Variant(value), result);
+    }
+}
+
+TEST_CASE("Validate string formats", "[validateFormat]") {
+    REQUIRE(validString("date-time", "2024-02-29T23:59:60.123Z"));
+    REQUIRE(validString("date-time", "1985-04-12t23:20:50+01:30"));
+    REQUIRE_FALSE(validString("date-time", "2023-02-29T10:00:00Z"));
+    REQUIRE_FALSE(validString("date-time", "2024-01-01T24:00:00Z"));
+    REQUIRE_FALSE(validString("date-time", "2024-01-01T10:00:00"));
+    REQUIRE(validString("date", "2000-02-29"));
+    REQUIRE_FALSE(validString("date", "1900-02-29"));
+    REQUIRE_FALSE(validString("date", "2000-13-01"));
+    REQUIRE(validString("time", "08:30:00-05:00"));
+    REQUIRE_FALSE(validString("time", "08:30-05:00"));
+
+    REQUIRE(validString("email", "first.last+tag@example.com"));
+    REQUIRE(validString("email", "\"john doe\"@[192.168.0.1]"));
+    REQUIRE_FALSE(validString("email", "first..last@example.com"));
+    REQUIRE_FALSE(validString("email", "@example.com"));
+    REQUIRE_FALSE(validString("email", "user@-example.com"));
+
+    REQUIRE(validString("hostname", "www.example-site.com"));
+    REQUIRE_FALSE(validString("hostname", "example-.com"));
+    REQUIRE_FALSE(validString("hostname", "exa_mple.com"));
+    REQUIRE_FALSE(validString("hostname", std::string(64, 'a') + ".com"));
+
+    REQUIRE(validString("ipv4", "192.168.0.255"));
+    REQUIRE_FALSE(validString("ipv4", "192.168.0.256"));
+    REQUIRE_FALSE(validString("ipv4", "192.168.01.1"));
+    REQUIRE_FALSE(validString("ipv4", "1.2.3"));
+
+    REQUIRE(validString("ipv6", "2001:db8::8a2e:370:7334"));
+    REQUIRE(validString("ipv6", "::"));
+    REQUIRE(validString("ipv6", "::ffff:192.168.0.1"));
+    REQUIRE(validString("ipv6", "1:2:3:4:5:6:7:8"));
+    REQUIRE_FALSE(validString("ipv6", "1:2:3:4:5:6:7:8:9"));
+    REQUIRE_FALSE(validString("ipv6", "1::2::3"));
+    REQUIRE_FALSE(validString("ipv6", "12345::"));
+
+    REQUIRE(validString("uri", "https://example.com/path?query=1#part"));
+    REQUIRE(validString("uri", "urn:isbn:0451450523"));
+    REQUIRE_FALSE(validString("uri", "/relative/path"));
+    REQUIRE_FALSE(validString("uri", "http://example.com/a b"));
+    REQUIRE_FALSE(validString("uri", "http://example.com/%zz"));
+
+    REQUIRE(validString("uuid", "123e4567-e89b-12d3-a456-426614174000"));
+    REQUIRE_FALSE(validString("uuid", "123e4567e89b-12d3-a456-426614174000-"));
+
+    REQUIRE(validString("json-pointer", ""));
+    REQUIRE(validString("json-pointer", "/a~1b/0/~0"));
+    REQUIRE_FALSE(validString("json-pointer", "a/b"));
+    REQUIRE_FALSE(validString("json-pointer", "/a~2"));
+
+    REQUIRE(validString("unknown-format", "anything"));
+}
+
+namespace {
+    std::string combinatorSchema{ R"(
+    {
+        "type": "object",
+        "properties": {
+            "id": { "anyOf": [ { "type": "string", "format": "uuid" }, { "type": "integer", "minimum": 1 } ] },
+            "color": { "enum": ["red", "green", "blue", "cyan", "magenta", "yellow", "black", "white", {"rgb": [0, 0, 0]}] },
+            "version": { "const": 2 },
+            "shape": {
+                "oneOf": [
+                    { "type": "object", "properties": { "radius": { "type": "number" } }, "required": ["radius"] },
+                    { "type": "object", "properties": { "side": { "type": "number" } }, "required": ["side"] }
+                ]
+            },
+            "name": { "allOf": [ { "type": "string", "minLength": 2 }, { "not": { "pattern": "^admin.*" } } ] },
+            "tags": { "type": ["array", "null"], "items": { "type": "string" }, "uniqueItems": true }
+        },
+        "patternProperties": { "^x-": { "type": "string" } },
+        "additionalProperties": false,
+        "dependentRequired": { "shape": ["version"] }
+    })" };
+
+    JsonSerialization::ValidationResult validateCombinators(const std::string& json)
+    {
+        JsonSerialization::Variant schemaVariant, variant;
+        JsonSerialization::Variant::fromJson(combinatorSchema, schemaVariant);
+        JsonSerialization::Variant::fromJson(json, variant);
+        JsonSerialization::ValidationResult result(true);
+        JsonSerialization::Variant::validate(schemaVariant, variant, result);
+        return result;
+    }
+}
+
+TEST_CASE("Validate combinators and keywords", "[validateCombinators]") {
+    REQUIRE(validateCombinators(R"({"id": 5, "color": {"rgb": [0, 0, 0]}, "version": 2, "shape": {"radius": 1.5}, "name": "Bob", "tags": null, "x-trace": "abc"})").isValid());
+    REQUIRE(validateCombinators(R"({"id": "123e4567-e89b-12d3-a456-426614174000", "color": "red", "tags": ["a", "b"]})").isValid());
+
+    auto result = validateCombinators(R"({"id": 0, "color": "purple", "version": 3, "name": "administrator", "tags": ["a", "a"], "x-trace": 1, "extra": true})");
+    REQUIRE(result.size() == 7);
+    REQUIRE(result[0].path == "/color");
+    REQUIRE(result[0].code == JsonSerialization::ValidationErrorCode::Enum);
+    REQUIRE(result[1].path == "/id");
+    REQUIRE(result[1].code == JsonSerialization::ValidationErrorCode::AnyOf);
+    REQUIRE(result[2].code == JsonSerialization::ValidationErrorCode::Not);
+    REQUIRE(result[3].code == JsonSerialization::ValidationErrorCode::UniqueItems);
+    REQUIRE(result[4].code == JsonSerialization::ValidationErrorCode::Const);
+    REQUIRE(result[5].path == "/extra");
+    REQUIRE(result[5].code == JsonSerialization::ValidationErrorCode::AdditionalProperties);
+    REQUIRE(result[6].path == "/x-trace");
+
+    result = validateCombinators(R"({"shape": {"radius": 1, "side": 2}})");
+    REQUIRE(result.size() == 2);
+    REQUIRE(result[0].code == JsonSerialization::ValidationErrorCode::DependentRequired);
+    REQUIRE(result[1].code == JsonSerialization::ValidationErrorCode::OneOf);
+    REQUIRE(result[1].path == "/shape");
+
+    // sizes beyond the range of int are compared as numbers
+    JsonSerialization::Variant sizeSchema;
+    REQUIRE(JsonSerialization::Variant::fromJson(R"({"maxItems": 1e10, "minItems": 3000000000})", sizeSchema));
+    REQUIRE_FALSE(JsonSerialization::Variant::validate(sizeSchema, JsonSerialization::VariantVector{ 1 }, result));
+    REQUIRE(result[0].code == JsonSerialization::ValidationErrorCode::MinItems);
+}
+
+TEST_CASE("Validate records and typed arrays like maps and vectors", "[validateShapes]") {
+    JsonSerialization::ParseOptions options;
+    options.shareShapes = true;
+    options.typedArrays = true;
+    JsonSerialization::Variant parsed;
+    REQUIRE(JsonSerialization::Variant::parse(R"([{"a": 3, "b": 1}, [1, 2]])", parsed, options));
+    const JsonSerialization::Variant& record = parsed.toVector()[0];
+    const JsonSerialization::Variant& numbers = parsed.toVector()[1];
+    REQUIRE(record.type() == JsonSerialization::Type::Record);
+    REQUIRE(numbers.type() == JsonSerialization::Type::NumberArray);
+
+    JsonSerialization::Variant map(JsonSerialization::VariantMap{ { "a", 3 }, { "b", 1 } });
+    JsonSerialization::Variant vector(JsonSerialization::VariantVector{ 1, 2 });
+    REQUIRE(record == map);
+    REQUIRE(numbers == vector);
+
+    JsonSerialization::Variant uniqueSchema(JsonSerialization::VariantMap{ { "type", "array" }, { "uniqueItems", true } });
+    JsonSerialization::ValidationResult result;
+    REQUIRE_FALSE(JsonSerialization::Variant::validate(uniqueSchema, JsonSerialization::VariantVector{ record, map }, result));
+    REQUIRE(result[0].code == JsonSerialization::ValidationErrorCode::UniqueItems);
+    REQUIRE_FALSE(JsonSerialization::Variant::validate(uniqueSchema, JsonSerialization::VariantVector{ numbers, vector }, result));
+    REQUIRE(JsonSerialization::Variant::validate(uniqueSchema, JsonSerialization::VariantVector{ record, numbers }, result));
+
+    // enough enum values for the hashed lookup
+    JsonSerialization::Variant enumSchema;
+    REQUIRE(JsonSerialization::Variant::fromJson(R"({"enum": [0, 1, 2, 3, 4, 5, 6, 7, {"a": 3, "b": 1}, [1, 2]]})", enumSchema));
+    REQUIRE(JsonSerialization::Variant::validate(enumSchema, record, result));
+    REQUIRE(JsonSerialization::Variant::validate(enumSchema, numbers, result));
+    REQUIRE_FALSE(JsonSerialization::Variant::validate(enumSchema, JsonSerialization::Variant(JsonSerialization::VariantVector{ 2, 1 }), result));
+
+    // the keywords of maps and vectors on records and typed arrays
+    JsonSerialization::Variant shapeSchema;
+    REQUIRE(JsonSerialization::Variant::fromJson(R"({"type": "array", "items": {"type": "object", "required": ["id"], "maxProperties": 2,
+        "properties": {"id": {"type": "integer"}, "scores": {"type": "array", "items": {"maximum": 10}, "uniqueItems": true}},
+        "additionalProperties": false}})", shapeSchema));
+    REQUIRE(JsonSerialization::Variant::parse(R"([{"id": 1, "scores": [1, 2]}, {"id": 2, "scores": [1.5, 2.5]}])", parsed, options));
+    REQUIRE(parsed.toVector()[0].type() == JsonSerialization::Type::Record);
+    REQUIRE(JsonSerialization::Variant::validate(shapeSchema, parsed, result));
+
+    REQUIRE(JsonSerialization::Variant::parse(R"([{"id": 1, "scores": [1, 1]}])", parsed, options));
+    REQUIRE_FALSE(JsonSerialization::Variant::validate(shapeSchema, parsed, result));
+    REQUIRE(result[0].code == JsonSerialization::ValidationErrorCode::UniqueItems);
+
+    REQUIRE(JsonSerialization::Variant::parse(R"([{"id": 1, "scores": [1.5, 12.5]}])", parsed, options));
+    REQUIRE_FALSE(JsonSerialization::Variant::validate(shapeSchema, parsed, result));
+    REQUIRE(result[0].code == JsonSerialization::ValidationErrorCode::Maximum);
+
+    REQUIRE(JsonSerialization::Variant::parse(R"([{"id": 1, "other": 2}, {"id": 2, "other": 3}])", parsed, options));
+    REQUIRE_FALSE(JsonSerialization::Variant::validate(shapeSchema, parsed, result));
+    REQUIRE(result[0].code == JsonSerialization::ValidationErrorCode::AdditionalProperties);
+
+    REQUIRE(JsonSerialization::Variant::parse(R"([{"scores": [1, 2]}, {"scores": [3, 4]}])", parsed, options));
+    REQUIRE_FALSE(JsonSerialization::Variant::validate(shapeSchema, parsed, result));
+    REQUIRE(result[0].code == JsonSerialization::ValidationErrorCode::Required);
+}